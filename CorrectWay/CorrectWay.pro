@@ -1,4 +1,6 @@
 TEMPLATE = subdirs
 
 SUBDIRS += \
-    CorrectWay
+    CorrectWay \
+    tests/expression \
+    tests/memory
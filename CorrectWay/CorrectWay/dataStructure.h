@@ -8,6 +8,13 @@
 #include<QString>
 #include <QStringList>
 #include <map>
+#include <deque>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include "tinyxml2.h"
 #include <QDir>
 #include <QTextStream>
@@ -16,7 +23,7 @@
  * \brief Коды основных типов данных
  * \enum MainDataType
  */
-enum MainDataType {
+enum MainDataType : uint8_t {
 
     DT_NONE,                                               ///< пустой тип данных
 
@@ -94,7 +101,16 @@ enum ErrorCode {
     ERROR_EXP_POINT_FIELD,                                        ///< ошибка у операции доступа к сложному типу данных операнд не является указателем на сложный тип данных
     ERROR_NO_CUSTOM_IN_DB,                                     ///< ошибка не удалось найти определение сложного типа данных
 
-    ERROR_NO_TEMPLATE                                              ///< ошибка не удалось определить шаблон
+    ERROR_NO_TEMPLATE,                                             ///< ошибка не удалось определить шаблон
+
+    // Коды, добавленные позже: новые коды дописываются только в конец, чтобы не менять значения уже существующих
+    ERROR_FUNC_PARAM_TYPE,                  ///< ошибка задания некорректного типа параметра функции
+    ERROR_METHOD_PARAM_TYPE,           ///< ошибка задания некорректного типа параметра метода
+    ERROR_ANALYZE_EXP_FUNC_ARITY,                ///< ошибка количество аргументов вызова не совпадает с количеством параметров функции
+    ERROR_FILE_XML_INCLUDE_CYCLE,     ///< ошибка циклического подключения библиотеки типов данных
+    ERROR_VAR_SIZE,                                  ///< ошибка задания некорректного размера массива у переменной
+    ERROR_FIELD_SIZE,                              ///< ошибка задания некорректного размера массива у поля
+    ERROR_ANALYZE_EXP_NO_OPERANDS,              ///< ошибка выражение не содержит ни одного операнда
 };
 
 /*!
@@ -116,6 +132,263 @@ enum templates{
     methodPointCall_          ///< шаблон вызов метода по указателю
 };
 
+/*!
+ * \brief Максимальное кол-во размерностей массива
+ */
+const int MAX_ARRAY_DIMENSIONS = 16;
+
+/*!
+ * \brief Атом - номер идентификатора в таблице строк
+ */
+typedef uint32_t Atom;
+
+/*!
+ * \brief Атом пустой строки
+ */
+const Atom EMPTY_ATOM = 0;
+
+/*!
+ * \class NoValue
+ * \brief Пустое значение записей OpenHashTable, используемой как множество
+ */
+struct NoValue {};
+
+/*!
+ * \class OpenHashTable
+ * \brief Хэш-таблица с открытой адресацией
+ *
+ * Записи хранятся блоками std::deque в порядке добавления, поэтому их адреса не меняются при добавлении новых.
+ * Ячейки таблицы хранят номер записи + 1 (0 у пустой ячейки), размер таблицы - степень двойки, заполнена
+ * таблица не более чем наполовину, а коллизии разрешаются линейным пробированием.
+ * Hash определяет статические методы hash(ключ) и equal(ключ записи, ключ); искать можно по ключу
+ * любого типа, для которого они определены и из которого конструируется Key
+ */
+template<class Key, class Value, class Hash>
+class OpenHashTable {
+public:
+    /*!
+     * \brief Запись таблицы
+     */
+    struct Entry {
+        Key key;            ///< ключ
+        Value value;      ///< значение
+    };
+
+    /*!
+     * \brief Метод очистки таблицы (указатели на записи становятся недействительными)
+     */
+    void clear(){
+        entries.clear();
+        slots.clear();
+    }
+
+    /*!
+     * \brief Метод добавления записи
+     * \param [in] key - ключ
+     * \param [in] value - значение (не используется, если запись с таким ключом уже есть)
+     * \return Запись с ключом и признак того, что она добавлена этим вызовом
+     */
+    template<class Lookup>
+    std::pair<Entry*, bool> insert(const Lookup& key, const Value& value){
+        if((entries.size() + 1) * 2 > slots.size()){
+            grow();
+        }
+        size_t slot = findSlot(key);
+        if(slots[slot] != 0){
+            return std::pair<Entry*, bool>(&entries[slots[slot] - 1], false);
+        }
+        entries.push_back(Entry{Key(key), value});
+        slots[slot] = (uint32_t)entries.size();
+        return std::pair<Entry*, bool>(&entries.back(), true);
+    }
+
+    /*!
+     * \brief Метод поиска записи
+     * \param [in] key - ключ
+     * \return Указатель на запись или nullptr, если записи с таким ключом нет
+     */
+    template<class Lookup>
+    const Entry* find(const Lookup& key) const{
+        if(slots.empty()){
+            return nullptr;
+        }
+        uint32_t index = slots[findSlot(key)];
+        return index != 0 ? &entries[index - 1] : nullptr;
+    }
+
+    /*!
+     * \brief Метод получения записи по номеру в порядке добавления
+     * \param [in] index - номер записи
+     * \return Запись
+     */
+    const Entry& at(size_t index) const{
+        return entries[index];
+    }
+
+    /*!
+     * \brief Метод получения количества записей
+     * \return Количество записей
+     */
+    int size() const{
+        return (int)entries.size();
+    }
+
+private:
+    std::deque<Entry> entries;           ///< записи в порядке добавления
+    std::vector<uint32_t> slots;          ///< ячейки таблицы: номер записи + 1 или 0 у пустой ячейки, размер - степень двойки
+
+    /*!
+     * \brief Метод поиска ячейки с ключом или первой пустой ячейки на пути линейного пробирования
+     */
+    template<class Lookup>
+    size_t findSlot(const Lookup& key) const{
+        size_t mask = slots.size() - 1;
+        size_t slot = Hash::hash(key) & mask;
+        while(slots[slot] != 0 && !Hash::equal(entries[slots[slot] - 1].key, key)){
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    /*!
+     * \brief Метод увеличения таблицы вдвое
+     */
+    void grow(){
+        slots.assign(slots.empty() ? 16 : slots.size() * 2, 0);
+        for(size_t i = 0; i < entries.size(); i++){
+            slots[findSlot(entries[i].key)] = (uint32_t)(i + 1);
+        }
+    }
+};
+
+/*!
+ * \class StringInterner
+ * \brief Таблица строк идентификаторов
+ *
+ * Текст каждого идентификатора хранится один раз, а одинаковые идентификаторы получают
+ * одинаковые атомы, поэтому идентификаторы сравниваются как целые числа
+ */
+class StringInterner {
+public:
+    /*!
+     * \brief Конструктор по умолчанию, пустая строка получает атом EMPTY_ATOM
+     */
+    StringInterner(){
+        intern("");
+    }
+
+    /*!
+     * \brief Метод получения атома строки, строка добавляется в таблицу при первом обращении
+     * \param [in] str - текст идентификатора
+     * \return Атом строки
+     */
+    Atom intern(std::string_view str){
+        return strings.insert(str, (Atom)strings.size()).first->value;
+    }
+
+    /*!
+     * \brief Метод получения текста идентификатора по атому
+     * \param [in] atom - атом идентификатора
+     * \return Текст идентификатора
+     */
+    const std::string& text(Atom atom) const{
+        return strings.at(atom).key;
+    }
+
+    /*!
+     * \brief Метод получения количества строк в таблице
+     * \return Количество строк
+     */
+    int size() const{
+        return strings.size();
+    }
+
+private:
+    /*!
+     * \brief Хэш строки (FNV-1a)
+     */
+    struct StringHash {
+        static size_t hash(std::string_view str){
+            uint64_t hash = 14695981039346656037ULL;
+            for(size_t i = 0; i < str.size(); i++){
+                hash = (hash ^ (unsigned char)str[i]) * 1099511628211ULL;
+            }
+            return (size_t)(hash ^ (hash >> 32));
+        }
+        static bool equal(const std::string& first, std::string_view second){
+            return first == second;
+        }
+    };
+
+    OpenHashTable<std::string, Atom, StringHash> strings;   ///< тексты идентификаторов и их атомы, номер записи - атом
+};
+
+/*!
+ * \class AtomSet
+ * \brief Множество атомов с открытой адресацией
+ */
+class AtomSet {
+public:
+    /*!
+     * \brief Метод очистки множества
+     */
+    void clear(){
+        atoms.clear();
+    }
+
+    /*!
+     * \brief Метод добавления атома в множество
+     * \param [in] atom - добавляемый атом
+     * \return Добавлен ли атом (false, если атом уже есть в множестве)
+     */
+    bool insert(Atom atom){
+        return atoms.insert(atom, NoValue()).second;
+    }
+
+    /*!
+     * \brief Метод проверки наличия атома в множестве
+     * \param [in] atom - искомый атом
+     * \return Есть ли атом в множестве
+     */
+    bool contains(Atom atom) const{
+        return atoms.find(atom) != nullptr;
+    }
+
+    /*!
+     * \brief Метод получения количества атомов в множестве
+     * \return Количество атомов
+     */
+    int size() const{
+        return atoms.size();
+    }
+
+private:
+    /*!
+     * \brief Хэш атома (мультипликативное хэширование)
+     */
+    struct AtomHash {
+        static size_t hash(Atom atom){
+            uint64_t hash = (uint64_t)atom * 11400714819323198485ULL;
+            return (size_t)(hash ^ (hash >> 32));
+        }
+        static bool equal(Atom first, Atom second){
+            return first == second;
+        }
+    };
+
+    OpenHashTable<Atom, NoValue, AtomHash> atoms;   ///< атомы множества
+};
+
+/*!
+ * \class DeclaredNames
+ * \brief Имена объявлений, уже прочитанных из XML, для поиска повторных объявлений при чтении
+ */
+struct DeclaredNames {
+    AtomSet variables;                ///< имена переменных
+    AtomSet functions;               ///< имена функций
+    AtomSet customData;           ///< имена пользовательских типов данных
+};
+
 /*!
  * \class DataType
  * \brief Класс типов данных
@@ -124,82 +397,62 @@ class DataType {
 public:
         MainDataType mainDataType; 			    ///< основной тип данных
         std::vector<int> arraySize;						///< размер массива (используется, если тип данных массив)
-        DataType* basicType;					        ///< базовый тип данных (используется, если тип данных является указателем или массивом)
-        std::string id;                                         ///< идентификатор переменной
+        const DataType* basicType;			        ///< базовый тип данных из пула типов данных (используется, если тип данных является указателем или массивом)
+        Atom id;                                                  ///< атом идентификатора пользовательского типа данных
 
         /*!
          * \brief Конструктор по умолчанию
          */
-        DataType (){};
+        DataType (){ id = EMPTY_ATOM; };
 
         /*!
-        * \brief Метод преобразования строкового представления размера массива в векторный вид
-        * \param [in] strSize - строка, которая содержит размер массива в текстовой записи
+        * \brief Метод чтения размера массива из аттрибута size узла XML
+        * \param [in] node - узел XML с описанием переменной или поля
+        * \param [out] errorPos - позиция в значении аттрибута, на которой обнаружена ошибка
+        * \return Корректен ли размер массива: все размерности - положительные целые числа (отсутствие аттрибута не является ошибкой)
         */
-        void convertStrSizeToVectorSize(std::string strSize){
-            std::vector<int> buff;
-            QString buff2;
-            QString strBuff = QString::fromStdString(strSize);
-            QStringList substr = strBuff.split(",");
-            QStringListIterator it(substr);
-
-            while (it.hasNext()){
-               buff2 = it.next();
-               buff.push_back(buff2.toInt());
+        bool readArraySizeFromXML(const tinyxml2::XMLElement* node, int& errorPos){
+            int sizes[MAX_ARRAY_DIMENSIONS]; //Размерности массива
+            int count = 0;                              //Кол-во размерностей массива
+            tinyxml2::XMLError result = node->QueryIntListAttribute("size", sizes, MAX_ARRAY_DIMENSIONS, &count, &errorPos);
+            if(result == tinyxml2::XML_WRONG_ATTRIBUTE_TYPE){
+                return false;
+            }
+            for(int i = 0; i < count; i++){
+                if(sizes[i] <= 0){ //Размерность массива должна быть положительной
+                    const char* size = node->Attribute("size");
+                    errorPos = 0;
+                    for(int commas = 0; commas < i; errorPos++){ //Найти начало i-й размерности
+                        if(size[errorPos] == ','){
+                            commas++;
+                        }
+                    }
+                    while(size[errorPos] == ' '){
+                        errorPos++;
+                    }
+                    return false;
+                }
             }
-            this->arraySize = buff;
+            this->arraySize.assign(sizes, sizes + count);
+            return true;
         }
 
         /*!
          * \brief Конструктор заполняющий информацию
          */
-        DataType(MainDataType mainDataType, std::vector<int> arraySize, DataType* basicType, std::string id){
+        DataType(MainDataType mainDataType, std::vector<int> arraySize, const DataType* basicType, Atom id){
             this->mainDataType = mainDataType;
             this->arraySize = arraySize;
             this->basicType = basicType;
             this->id = id;
         }
 
-        /*!
-        * \brief Метод преобразования строкового представления типа данных в реальный тип данных
-        * \param [in] strDT - строка которую необходимо преобразовать в реальный тип данных
-        */
-        void convertStrDTToRealDT(QString strDT){
-            QString strBuff = strDT;
-            if(!arraySize.empty()){
-                this->mainDataType = DT_ARRAY;
-                this->basicType = new DataType();
-                if(strBuff.contains("*")){
-                    this->basicType->mainDataType = DT_POINTER;
-                    strBuff.remove("*");
-                    this->basicType->basicType = new DataType();
-                    this->basicType->basicType->mainDataType = convertStrDTToBasicDT(strBuff);
-                    strBuff = deleteSpaces(strBuff.toStdString());
-                    this->basicType->basicType->id = strBuff.toStdString();}
-                else {
-                    this->basicType->mainDataType = convertStrDTToBasicDT(strBuff);
-                    strBuff = deleteSpaces(strBuff.toStdString());
-                    this->basicType->id = strBuff.toStdString();
-                }
-            } else  if(strBuff.contains("*")){
-                        this->mainDataType = DT_POINTER;
-                        this->basicType = new DataType();
-                        strBuff.remove("*");
-                        this->basicType->mainDataType = convertStrDTToBasicDT(strBuff);
-                        strBuff = deleteSpaces(strBuff.toStdString());
-                         this->basicType->id = strBuff.toStdString();
-            } else {
-                this->mainDataType = convertStrDTToBasicDT(strBuff);
-                strBuff = deleteSpaces(strBuff.toStdString());
-                 this->id = strBuff.toStdString(); }
-        }
-
         /*!
         * \brief Метод распознания типов данных в поданной строке
         * \param [in] strBasicDT - строка в которой необходимо определить тип данных
         * \return  Тип данных найденный в строке
         */
-        MainDataType convertStrDTToBasicDT(QString& strBasicDT){
+        static MainDataType convertStrDTToBasicDT(QString& strBasicDT){
                 if(strBasicDT.contains ("int")){  strBasicDT.remove("int"); return DT_INT;}
                 else if(strBasicDT.contains ( "float")){strBasicDT.remove("float"); return DT_FLOAT;}
                 else if(strBasicDT.contains ("class")){strBasicDT.remove("class"); return DT_CLASS;}
@@ -212,7 +465,7 @@ public:
         * \param [in] str - строка в которой необходимо удалить пробелы
         * \return  Преобразованная строка
         */
-        QString deleteSpaces(std::string str){
+        static QString deleteSpaces(std::string str){
             QString strBuff = QString::fromStdString(str);
             for(int i = 0; i<str.length(); i++){
                 strBuff.remove(" ");
@@ -221,6 +474,99 @@ public:
         }
 };
 
+/*!
+ * \class DataTypePool
+ * \brief Пул типов данных
+ *
+ * Каждый различный тип данных хранится в пуле один раз, а базовые типы указателей и массивов
+ * также берутся из пула, поэтому равные типы данных имеют один адрес.
+ * Пул владеет всеми своими типами данных и освобождает их вместе с собой
+ */
+class DataTypePool {
+public:
+    /*!
+     * \brief Конструктор по умолчанию
+     */
+    DataTypePool(){}
+
+    DataTypePool(const DataTypePool&) = delete;
+    DataTypePool& operator=(const DataTypePool&) = delete;
+
+    /*!
+     * \brief Метод получения типа данных из пула, тип данных добавляется в пул при первом обращении
+     * \param [in] type - тип данных, базовый тип которого уже взят из пула
+     * \return Указатель на тип данных в пуле
+     */
+    const DataType* intern(const DataType& type){
+        return &types.insert(type, NoValue()).first->key;
+    }
+
+    /*!
+     * \brief Метод преобразования строкового представления типа данных в реальный тип данных
+     * \param [in] strDT - строка которую необходимо преобразовать в реальный тип данных
+     * \param [in] arraySize - размер массива (пустой, если тип данных не является массивом)
+     * \param [in|out] atoms - таблица строк, в которую добавляется имя пользовательского типа данных
+     * \return Указатель на тип данных в пуле
+     */
+    const DataType* internFromString(QString strDT, const std::vector<int>& arraySize, StringInterner& atoms){
+        QString strBuff = strDT;
+        if(!arraySize.empty()){
+            const DataType* basicType;
+            if(strBuff.contains("*")){
+                strBuff.remove("*");
+                basicType = intern(DataType(DT_POINTER, {}, internBasicDT(strBuff, atoms), EMPTY_ATOM));
+            } else {
+                basicType = internBasicDT(strBuff, atoms);
+            }
+            return intern(DataType(DT_ARRAY, arraySize, basicType, EMPTY_ATOM));
+        } else if(strBuff.contains("*")){
+            strBuff.remove("*");
+            return intern(DataType(DT_POINTER, {}, internBasicDT(strBuff, atoms), EMPTY_ATOM));
+        }
+        return internBasicDT(strBuff, atoms);
+    }
+
+    /*!
+     * \brief Метод получения количества типов данных в пуле
+     * \return Количество типов данных
+     */
+    int size() const{
+        return types.size();
+    }
+
+private:
+    /*!
+     * \brief Хэш типа данных (FNV-1a по полям, базовый тип сравнивается по адресу, так как он взят из пула)
+     */
+    struct DataTypeHash {
+        static size_t hash(const DataType& type){
+            uint64_t hash = 14695981039346656037ULL;
+            hash = (hash ^ (uint64_t)type.mainDataType) * 1099511628211ULL;
+            for(size_t i = 0; i < type.arraySize.size(); i++){
+                hash = (hash ^ (uint64_t)(uint32_t)type.arraySize[i]) * 1099511628211ULL;
+            }
+            hash = (hash ^ (uint64_t)(uintptr_t)type.basicType) * 1099511628211ULL;
+            hash = (hash ^ (uint64_t)type.id) * 1099511628211ULL;
+            return (size_t)(hash ^ (hash >> 32));
+        }
+        static bool equal(const DataType& first, const DataType& second){
+            return first.mainDataType == second.mainDataType && first.basicType == second.basicType &&
+                   first.id == second.id && first.arraySize == second.arraySize;
+        }
+    };
+
+    OpenHashTable<DataType, NoValue, DataTypeHash> types;   ///< типы данных пула, адреса не меняются при добавлении
+
+    /*!
+     * \brief Метод получения из пула базового (не составного) типа данных по строке
+     */
+    const DataType* internBasicDT(QString strBasicDT, StringInterner& atoms){
+        MainDataType mainDataType = DataType::convertStrDTToBasicDT(strBasicDT);
+        Atom id = atoms.intern(DataType::deleteSpaces(strBasicDT.toStdString()).toStdString());
+        return intern(DataType(mainDataType, {}, nullptr, id));
+    }
+};
+
 /*!
  * \class ErrorInfo
  * \brief Класс описаний ошибок в работе программы
@@ -250,13 +596,13 @@ public:
    /*!
     * \brief Метод создания ошибки
     */
-   QString createErrorMessage(){
+   QString createErrorMessage() const{
        QString error;
 
        switch (this->errorCode) {
 
        case ERROR_CMD:                                                  ///< ошибка неверного числа аргументов
-           error = "Ошибка: ожидаемое кол-во аргументов командной строки: 3-4, действительное: " + this->errorContent[0];
+           error = "Ошибка: ожидаемое кол-во аргументов командной строки: 3-5, действительное: " + this->errorContent[0];
            break;
 
        case ERROR_FILE:                                                  ///< ошибка открытия файла для чтения
@@ -272,6 +618,9 @@ public:
        case ERROR_FILE_XML_ATTRIBUTE:             ///< ошибка отсутствия необходимого аттрибута узла
             error = "Ошибка: у дочернего узла " + this->errorContent[0] + this->errorContent[1] + " отсутствует необходимый аттрибут: " + this->errorContent[2];
            break;
+       case ERROR_FILE_XML_INCLUDE_CYCLE:     ///< ошибка циклического подключения библиотеки типов данных
+           error = "Ошибка: циклическое подключение библиотек типов данных " + this->errorContent[0];
+           break;
 
 
        case ERROR_VAR_NAME:                                 ///< ошибка задания некорректного имени переменной
@@ -283,6 +632,9 @@ public:
        case ERROR_VAR_CPP:                                   ///< ошибка имя переменной принадлежит списку зарезервированных слов
            error = "Ошибка: заданое имя переменной " + this->errorContent[0] + ", является ключевым словом";
            break;
+       case ERROR_VAR_SIZE:                                  ///< ошибка задания некорректного размера массива у переменной
+           error = "Ошибка: задан некорректный размер массива " + this->errorContent[1] + " у переменной: " + this->errorContent[0] + " в позиции " + this->errorContent[2];
+           break;
 
 
        case ERROR_FUNC_NAME:                              ///< ошибка задания имени функции
@@ -294,6 +646,9 @@ public:
        case ERROR_FUNC_CPP:                                ///< ошибка имя функции принадлежит списку зарезервированных слов
             error = "Ошибка: заданое имя функции " + this->errorContent[0] + ", является ключевым словом";
            break;
+       case ERROR_FUNC_PARAM_TYPE:                  ///< ошибка задания некорректного типа параметра функции
+            error = "Ошибка: у функции " + this->errorContent[0] + " задан некорректный тип параметра " + this->errorContent[1];
+           break;
 
        case ERROR_CUSTOMDATA_NAME:                ///< ошибка задания имя пользовательского типа данных
            error = "Ошибка: задано некорректное имя пользовательского типа данных:" + this->errorContent[0];
@@ -311,6 +666,9 @@ public:
        case ERROR_FIELD_CPP:                               ///< ошибка имя поля принадлежит списку зарезервированных слов
            error = "Ошибка: у пользовательского типа данных " + this->errorContent[0] + " имя поля является ключевым словом " + this->errorContent[1];
            break;
+       case ERROR_FIELD_SIZE:                              ///< ошибка задания некорректного размера массива у поля
+           error = "Ошибка: у пользовательского типа данных " + this->errorContent[0] + " задан некорректный размер массива " + this->errorContent[2] + " у поля " + this->errorContent[1] + " в позиции " + this->errorContent[3];
+           break;
 
        case ERROR_METHOD_NAME:                       ///< ошибка задания имени метода
           error = "Ошибка:у пользовательского типа данных "+ this->errorContent[0] +  " задано некорректное имя метода:" + this->errorContent[1];
@@ -321,6 +679,9 @@ public:
        case ERROR_METHOD_CPP:                         ///< ошибка имя метода принадлежит списку зарезервированных слов
           error = "Ошибка: у пользовательского типа данных " + this->errorContent[0] + " имя метода является ключевым словом " + this->errorContent[1];
            break;
+       case ERROR_METHOD_PARAM_TYPE:           ///< ошибка задания некорректного типа параметра метода
+           error = "Ошибка: у пользовательского типа данных " + this->errorContent[0] + " у метода " + this->errorContent[1] + " задан некорректный тип параметра " + this->errorContent[2];
+           break;
 
        case ERROR_COPY_FUNC_NAME:                ///< ошибка найденный две функции с одинаковым именем
            error = "Ошибка: найдено несколько объявлений функций с именем:" + this->errorContent[0];
@@ -362,6 +723,12 @@ public:
        case ERROR_ANALYZE_EXP_INCORRECT_FUNC_NAME:   ///< ошибка некорректное имя функции
             error ="Ошибка: вызов функции с некорректным именем: " + this->errorContent[0];
            break;
+       case ERROR_ANALYZE_EXP_FUNC_ARITY:                 ///< ошибка количество аргументов вызова не совпадает с количеством параметров функции
+            error ="Ошибка: функция " + this->errorContent[0] + " вызвана с количеством аргументов " + this->errorContent[1] + ", а объявлена с количеством параметров " + this->errorContent[2];
+           break;
+       case ERROR_ANALYZE_EXP_NO_OPERANDS:              ///< ошибка выражение не содержит ни одного операнда
+            error ="Ошибка: выражение не содержит ни одного операнда: " + this->errorContent[0];
+           break;
 
        case ERROR_OUT_OF_RANGE_ARRAY:                               ///< ошибка выхода за пределы массива
            error ="Ошибка: у массива с именем " + this->errorContent[1] + " осуществляется выход за пределы массива со значением" +  this->errorContent[0];
@@ -392,26 +759,286 @@ public:
        }
        return error;
    }
+
+   /*!
+    * \brief Метод получения имени кода ошибки (не зависит от порядка кодов в перечислении)
+    * \return Имя кода ошибки
+    */
+   const char* errorCodeName() const{
+       switch (this->errorCode) {
+       case ERROR_CMD: return "ERROR_CMD";
+       case ERROR_FILE: return "ERROR_FILE";
+       case ERROR_NO_EXPRESSION_AND_TEXT: return "ERROR_NO_EXPRESSION_AND_TEXT";
+       case ERROR_FILE_XML_OPEN: return "ERROR_FILE_XML_OPEN";
+       case ERROR_FILE_XML_ATTRIBUTE: return "ERROR_FILE_XML_ATTRIBUTE";
+       case ERROR_FILE_XML_INCLUDE_CYCLE: return "ERROR_FILE_XML_INCLUDE_CYCLE";
+       case ERROR_VAR_NAME: return "ERROR_VAR_NAME";
+       case ERROR_VAR_TYPE: return "ERROR_VAR_TYPE";
+       case ERROR_VAR_CPP: return "ERROR_VAR_CPP";
+       case ERROR_VAR_SIZE: return "ERROR_VAR_SIZE";
+       case ERROR_FUNC_NAME: return "ERROR_FUNC_NAME";
+       case ERROR_FUNC_RETURNTYPE: return "ERROR_FUNC_RETURNTYPE";
+       case ERROR_FUNC_CPP: return "ERROR_FUNC_CPP";
+       case ERROR_FUNC_PARAM_TYPE: return "ERROR_FUNC_PARAM_TYPE";
+       case ERROR_CUSTOMDATA_NAME: return "ERROR_CUSTOMDATA_NAME";
+       case ERROR_CUSTOMDATA_CPP: return "ERROR_CUSTOMDATA_CPP";
+       case ERROR_FIELD_NAME: return "ERROR_FIELD_NAME";
+       case ERROR_FIELD_TYPE: return "ERROR_FIELD_TYPE";
+       case ERROR_FIELD_CPP: return "ERROR_FIELD_CPP";
+       case ERROR_FIELD_SIZE: return "ERROR_FIELD_SIZE";
+       case ERROR_METHOD_NAME: return "ERROR_METHOD_NAME";
+       case ERROR_METOD_RETURNTYPE: return "ERROR_METOD_RETURNTYPE";
+       case ERROR_METHOD_CPP: return "ERROR_METHOD_CPP";
+       case ERROR_METHOD_PARAM_TYPE: return "ERROR_METHOD_PARAM_TYPE";
+       case ERROR_COPY_FUNC_NAME: return "ERROR_COPY_FUNC_NAME";
+       case ERROR_COPY_VAR_NAME: return "ERROR_COPY_VAR_NAME";
+       case ERROR_COPY_FIELD_NAME: return "ERROR_COPY_FIELD_NAME";
+       case ERROR_COPY_CUSTOMDATA_NAME: return "ERROR_COPY_CUSTOMDATA_NAME";
+       case ERROR_COPY_FUNC_VAR_NAME: return "ERROR_COPY_FUNC_VAR_NAME";
+       case ERROR_COPY_METHOD_NAME: return "ERROR_COPY_METHOD_NAME";
+       case ERROR_ANALYZE_EXP_TRASH: return "ERROR_ANALYZE_EXP_TRASH";
+       case ERROR_ANALYZE_EXP_MORE_VAR: return "ERROR_ANALYZE_EXP_MORE_VAR";
+       case ERROR_ANALYZE_EXP_MORE_OP: return "ERROR_ANALYZE_EXP_MORE_OP";
+       case ERROR_ANALYZE_EXP_NO_VAR_IN_DB: return "ERROR_ANALYZE_EXP_NO_VAR_IN_DB";
+       case ERROR_ANALYZE_EXP_INCORRECT_FUNC_NAME: return "ERROR_ANALYZE_EXP_INCORRECT_FUNC_NAME";
+       case ERROR_ANALYZE_EXP_FUNC_ARITY: return "ERROR_ANALYZE_EXP_FUNC_ARITY";
+       case ERROR_ANALYZE_EXP_NO_OPERANDS: return "ERROR_ANALYZE_EXP_NO_OPERANDS";
+       case ERROR_OUT_OF_RANGE_ARRAY: return "ERROR_OUT_OF_RANGE_ARRAY";
+       case ERROR_EXP_INT: return "ERROR_EXP_INT";
+       case ERROR_EXP_ARRAY: return "ERROR_EXP_ARRAY";
+       case ERROR_EXP_CUSTOM: return "ERROR_EXP_CUSTOM";
+       case ERROR_EXP_FIELD: return "ERROR_EXP_FIELD";
+       case ERROR_EXP_POINT_FIELD: return "ERROR_EXP_POINT_FIELD";
+       case ERROR_NO_CUSTOM_IN_DB: return "ERROR_NO_CUSTOM_IN_DB";
+       case ERROR_NO_TEMPLATE: return "ERROR_NO_TEMPLATE";
+       }
+       return "";
+   }
+};
+
+struct CustomDataInfo;
+
+/*!
+ * \class ResolvedType
+ * \brief Разрешенный тип данных объявления или вершины выражения
+ *
+ * Цепочка DataType::basicType сворачивается один раз после чтения объявлений,
+ * чтобы проверки выражения не обходили ее и не искали пользовательский тип данных по имени
+ */
+struct ResolvedType {
+    MainDataType baseType;                ///< базовый тип данных после снятия массивов и указателей (DT_NONE, если тип не удалось определить)
+    uint8_t pointerDepth;                  ///< количество уровней указателей
+    uint8_t arrayDimensions;             ///< количество оставшихся размерностей массива
+    const DataType* arrayType;          ///< тип данных массива с размерами всех размерностей (nullptr, если тип данных не массив)
+    CustomDataInfo* customData;      ///< пользовательский тип данных базового типа (nullptr, если базовый тип не пользовательский или не объявлен)
+
+    /*!
+     * \brief Метод проверки является ли тип целочисленным (не указателем и не массивом)
+     * \return Является ли тип целочисленным
+     */
+    bool isInteger() const{
+        return baseType == DT_INT && pointerDepth == 0 && arrayDimensions == 0;
+    }
+
+    /*!
+     * \brief Метод получения размера текущей (первой из оставшихся) размерности массива
+     * \return Размер размерности
+     */
+    int currentArraySize() const{
+        return arrayType->arraySize[arrayType->arraySize.size() - arrayDimensions];
+    }
 };
 
+/*!
+ * \brief Тип, который не удалось определить
+ */
+const ResolvedType UNRESOLVED_TYPE = {DT_NONE, 0, 0, nullptr, nullptr};
+
 /*!
  * \class VariableInfo
  * \brief Информация о переменной
  */
 struct VariableInfo {
-    std::string id;                                        ///< идентификатор переменной
-    DataType dataType;                            ///< тип данных переменной
+    Atom id;                                                  ///< атом идентификатора переменной
+    const DataType* dataType;                  ///< тип данных переменной из пула типов данных
     std::string dataTypeStr;                        ///< тип данных переменной в строковом представлении
+    ResolvedType resolvedType;                ///< разрешенный тип данных переменной
 };
 
+const int ANY_ARITY = -1; ///< количество параметров функции, у которой не задан список параметров
+
 /*!
  * \class FunctionInfo
  * \brief Информация о функциях
  */
 struct FunctionInfo {
-    std::string id;                                ///< идентификатор функции
-    DataType returnType;                ///< тип данных возвращаемого значения
+    Atom id;                                          ///< атом идентификатора функции
+    const DataType* returnType;      ///< тип данных возвращаемого значения из пула типов данных
     std::string returnTypeStr;              ///< тип данных возвращаемого значения в строковом представлении
+    ResolvedType resolvedType;         ///< разрешенный тип данных возвращаемого значения
+    int arity;                                          ///< количество параметров (ANY_ARITY, если список параметров не задан)
+    std::vector<const DataType*> paramTypes; ///< типы данных параметров из пула типов данных
+};
+
+/*!
+ * \brief Виды объявлений в таблице символов
+ * \enum SymbolKind
+ */
+enum SymbolKind {
+    SYMBOL_VARIABLE,             ///< переменная
+    SYMBOL_FUNCTION,             ///< функция
+    SYMBOL_CUSTOM_DATA       ///< пользовательский тип данных
+};
+
+/*!
+ * \class SymbolInfo
+ * \brief Разрешенное объявление идентификатора
+ */
+struct SymbolInfo {
+    SymbolKind kind;                                 ///< вид объявления
+    Atom id;                                               ///< атом идентификатора
+    const DataType* dataType;                 ///< тип данных переменной или возвращаемого значения функции (nullptr у пользовательского типа данных)
+    const ResolvedType* type;                ///< разрешенный тип данных переменной или возвращаемого значения функции (nullptr у пользовательского типа данных)
+    CustomDataInfo* customData;             ///< сам пользовательский тип данных (nullptr у переменной и функции)
+    VariableInfo* variable;                      ///< объявление переменной
+    FunctionInfo* function;                     ///< объявление функции
+};
+
+/*!
+ * \class SymbolTable
+ * \brief Таблица символов с открытой адресацией
+ *
+ * Переменные, функции и пользовательские типы данных хранятся в одной таблице,
+ * ключом является пара (атом идентификатора, вид объявления)
+ */
+class SymbolTable {
+public:
+    /*!
+     * \brief Метод очистки таблицы
+     */
+    void clear(){
+        symbols.clear();
+    }
+
+    /*!
+     * \brief Метод добавления объявления в таблицу
+     * \param [in] symbol - разрешенное объявление
+     * \return Добавлено ли объявление (false, если объявление с таким идентификатором и видом уже есть)
+     */
+    bool insert(const SymbolInfo& symbol){
+        return symbols.insert(SymbolKey(symbol.id, symbol.kind), symbol).second;
+    }
+
+    /*!
+     * \brief Метод поиска объявления
+     * \param [in] id - атом идентификатора
+     * \param [in] kind - вид объявления
+     * \return Указатель на объявление или nullptr, если объявление не найдено
+     */
+    const SymbolInfo* find(Atom id, SymbolKind kind) const{
+        const OpenHashTable<SymbolKey, SymbolInfo, SymbolKeyHash>::Entry* entry = symbols.find(SymbolKey(id, kind));
+        return entry != nullptr ? &entry->value : nullptr;
+    }
+
+    /*!
+     * \brief Метод получения количества объявлений в таблице
+     * \return Количество объявлений
+     */
+    int size() const{
+        return symbols.size();
+    }
+
+private:
+    /*!
+     * \brief Ключ объявления: атом идентификатора и вид объявления
+     */
+    typedef std::pair<Atom, SymbolKind> SymbolKey;
+
+    /*!
+     * \brief Хэш ключа (мультипликативное хэширование атома и вида объявления)
+     */
+    struct SymbolKeyHash {
+        static size_t hash(const SymbolKey& key){
+            uint64_t hash = (((uint64_t)key.first << 2) | (uint64_t)key.second) * 11400714819323198485ULL;
+            return (size_t)(hash ^ (hash >> 32));
+        }
+        static bool equal(const SymbolKey& first, const SymbolKey& second){
+            return first == second;
+        }
+    };
+
+    OpenHashTable<SymbolKey, SymbolInfo, SymbolKeyHash> symbols;   ///< объявления по ключу
+};
+
+/*!
+ * \class SignatureTable
+ * \brief Таблица сигнатур с открытой адресацией
+ *
+ * Ключом является пара (атом идентификатора, количество параметров), поэтому вызов
+ * находит свое объявление за одно обращение вместе с проверкой количества аргументов
+ */
+class SignatureTable {
+public:
+    /*!
+     * \brief Метод очистки таблицы
+     */
+    void clear(){
+        signatures.clear();
+    }
+
+    /*!
+     * \brief Метод добавления сигнатуры функции в таблицу
+     * \param [in] function - объявление функции
+     * \return Добавлена ли сигнатура (false, если такая сигнатура уже есть)
+     */
+    bool insert(FunctionInfo* function){
+        return signatures.insert(SignatureKey(function->id, function->arity), function).second;
+    }
+
+    /*!
+     * \brief Метод поиска объявления, подходящего для вызова
+     * \param [in] id - атом идентификатора функции
+     * \param [in] arity - количество аргументов вызова
+     * \return Указатель на объявление или nullptr, если функции с таким количеством параметров нет
+     */
+    FunctionInfo* find(Atom id, int arity) const{
+        const OpenHashTable<SignatureKey, FunctionInfo*, SignatureKeyHash>::Entry* exact = signatures.find(SignatureKey(id, arity));
+        if(exact != nullptr){
+            return exact->value;
+        }
+        //функция без списка параметров принимает любое количество аргументов
+        const OpenHashTable<SignatureKey, FunctionInfo*, SignatureKeyHash>::Entry* any = signatures.find(SignatureKey(id, ANY_ARITY));
+        return any != nullptr ? any->value : nullptr;
+    }
+
+    /*!
+     * \brief Метод получения количества сигнатур в таблице
+     * \return Количество сигнатур
+     */
+    int size() const{
+        return signatures.size();
+    }
+
+private:
+    /*!
+     * \brief Ключ сигнатуры: атом идентификатора и количество параметров
+     */
+    typedef std::pair<Atom, int> SignatureKey;
+
+    /*!
+     * \brief Хэш ключа (мультипликативное хэширование атома и количества параметров)
+     */
+    struct SignatureKeyHash {
+        static size_t hash(const SignatureKey& key){
+            uint64_t hash = (((uint64_t)key.first << 16) ^ (uint64_t)(uint16_t)key.second) * 11400714819323198485ULL;
+            return (size_t)(hash ^ (hash >> 32));
+        }
+        static bool equal(const SignatureKey& first, const SignatureKey& second){
+            return first == second;
+        }
+    };
+
+    OpenHashTable<SignatureKey, FunctionInfo*, SignatureKeyHash> signatures;   ///< объявления функций по сигнатуре
 };
 
 /*!
@@ -419,27 +1046,116 @@ struct FunctionInfo {
  * \brief Информация о пользовательском типе данных
  */
 struct CustomDataInfo {
-    std::string id;                                                     ///< идентификатор пользовательского типа данных
+    Atom id;                                                               ///< атом идентификатора пользовательского типа данных
     MainDataType type;                                         ///< тип пользовательского типа данных (может быть равен только CLASS, UNION или STRUCT)
     std::vector<VariableInfo*> fields;                       ///< набор полей пользовательского типа данных
     std::vector<FunctionInfo*> methods;                 ///< набор методов пользовательского типа данных
+    SymbolTable members;                                        ///< таблица членов: поля как SYMBOL_VARIABLE, методы как SYMBOL_FUNCTION
+    SignatureTable methodSignatures;                     ///< таблица сигнатур методов
 };
 
 /*!
- * \class ExpressionNeededInfo
- * \brief Класс вспомогательной информации для конвертации выражения
+ * \class DeclarationStore
+ * \brief Хранилище объявлений контекста задания
+ *
+ * Объявления размещаются блоками std::deque: указатели на них не меняются при добавлении
+ * новых объявлений, а все объявления освобождаются вместе с хранилищем, в том числе
+ * объявления, отброшенные из-за ошибок чтения
  */
-struct ExpressionNeededInfo {
-    std::vector<VariableInfo*> variablesInfo;               ///< набор описаний переменных
-    std::vector<FunctionInfo*> functionsInfo;             ///< набор описаний функций
-    std::vector<CustomDataInfo*> customDataInfo;   ///< набор описаний пользовательских типов данных
+class DeclarationStore {
+public:
+    DeclarationStore() = default;
+    DeclarationStore(const DeclarationStore&) = delete;
+    DeclarationStore& operator=(const DeclarationStore&) = delete;
+
+    /*!
+     * \brief Метод размещения описания переменной (поля)
+     * \param [in] info - описание
+     * \return Указатель на размещенное описание
+     */
+    VariableInfo* newVariable(VariableInfo&& info){
+        variables.push_back(std::move(info));
+        return &variables.back();
+    }
+
+    /*!
+     * \brief Метод размещения описания функции (метода)
+     * \param [in] info - описание
+     * \return Указатель на размещенное описание
+     */
+    FunctionInfo* newFunction(FunctionInfo&& info){
+        functions.push_back(std::move(info));
+        return &functions.back();
+    }
+
+    /*!
+     * \brief Метод размещения описания пользовательского типа данных
+     * \param [in] info - описание
+     * \return Указатель на размещенное описание
+     */
+    CustomDataInfo* newCustomData(CustomDataInfo&& info){
+        customData.push_back(std::move(info));
+        return &customData.back();
+    }
+
+private:
+    std::deque<VariableInfo> variables;          ///< описания переменных и полей
+    std::deque<FunctionInfo> functions;         ///< описания функций и методов
+    std::deque<CustomDataInfo> customData;  ///< описания пользовательских типов данных
+};
+
+/*!
+ * \class TypeLibrary
+ * \brief Библиотека пользовательских типов данных, подключаемая к XML файлу через <include href="..."/>
+ *
+ * Библиотека читается и проверяется один раз для каждой версии файла, таблицы членов ее типов
+ * строятся при загрузке, после чего библиотека не изменяется и только читается всеми подключившими ее контекстами.
+ * Библиотеку удерживают кэш (пока она текущая), подключившие ее контексты и библиотеки, поэтому она освобождается,
+ * когда ее не использует ни один из них
+ */
+struct TypeLibrary {
+    std::string path;                                                                   ///< абсолютный путь к XML файлу библиотеки
+    long long modified;                                                               ///< время изменения файла, из которого загружена библиотека (мс)
+    std::vector<CustomDataInfo*> customDataInfo;                      ///< собственные пользовательские типы данных библиотеки
+    std::vector<CustomDataInfo*> visibleCustomDataInfo;          ///< собственные типы данных вместе с типами вложенных подключений
+    std::vector<std::shared_ptr<const TypeLibrary>> includes;  ///< непосредственно подключенные библиотеки (те версии, с которыми она загружена)
+    std::vector<ErrorInfo> errorsInfo;                                         ///< ошибки чтения библиотеки (передаются каждому подключившему ее файлу)
+    DeclarationStore declarations;                                           ///< хранилище объявлений библиотеки
+};
+
+/*!
+ * \class TypeLibraryCache
+ * \brief Библиотеки пользовательских типов данных, загруженные за время работы процесса
+ *
+ * Все библиотеки используют общую таблицу строк, поэтому контекст, таблица строк которого начата
+ * с ее копии, получает те же атомы и ссылается на типы данных библиотек без их повторного чтения.
+ * Библиотеки, таблица строк и пул типов данных изменяются только под mutex, поэтому контексты
+ * разных потоков могут подключать библиотеки одновременно. Кэш хранит только текущую версию каждого файла:
+ * измененный файл (или библиотека, загруженная со старыми версиями вложенных подключений) читается заново,
+ * а прежняя версия освобождается, когда ее отпустят все контексты, ссылающиеся на ее типы данных
+ */
+struct TypeLibraryCache {
+    StringInterner atoms;                                                     ///< общая таблица строк библиотек
+    DataTypePool types;                                                       ///< общий пул типов данных библиотек
+    std::map<std::string, std::shared_ptr<const TypeLibrary>> libraries; ///< текущие версии загруженных библиотек по абсолютному пути
+    std::vector<std::string> loading;                                  ///< пути библиотек, загружаемых сейчас, в порядке вложенности (для поиска циклов)
+    std::recursive_mutex mutex;                                           ///< защита загрузки библиотек (вложенные подключения загружаются тем же потоком)
+
+    /*!
+     * \brief Метод получения копии общей таблицы строк, с которой начинается таблица строк контекста
+     * \return Копия таблицы строк
+     */
+    StringInterner copyAtoms(){
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        return atoms;
+    }
 };
 
 /*!
 *\brief Типы вершин графа
 *\enum NodeType
 */
-enum NodeType
+enum NodeType : uint8_t
 {
     constant_int,                       ///<константа целочисленная
     constant_float,                    ///<константа вещественная
@@ -451,7 +1167,7 @@ enum NodeType
 *\enum Operator
 *\brief Список операторов
 */
-enum Operator
+enum Operator : uint8_t
 {
     arrayItem,                         ///< "[]"
     mul,                                 ///< "*"
@@ -464,6 +1180,175 @@ enum Operator
     pointer                          ///< непрямое обращение
 };
 
+/*!
+ * \brief Свойства оператора
+ */
+struct OperatorTraits {
+    const char* symbol;                  ///< строковое представление оператора
+    int arity;                                 ///< количество операндов (-1 - произвольное)
+    bool commutative;                   ///< признак коммутативности (вложенные одноименные операторы объединяются, операнды сортируются)
+    const char* text;                       ///< текстовое представление оператора на русском языке
+};
+
+/*!
+ * \brief Таблица свойств операторов, индекс - значение Operator
+ */
+constexpr OperatorTraits OPERATOR_TRAITS[] = {
+    {"____", 2, false, "доступ к члену массива"},
+    {"*", 2, true, "multable"},
+    {"->", 2, false, "arrow"},
+    {".", 2, false, "dot"},
+    {"/", 2, false, "divide"},
+    {"-", 2, false, "subtract"},
+    {"+", 2, true, "addiction"},
+    {"____", -1, false, "function call"},
+    {"*", 1, false, "pointer"}
+};
+
+/*!
+ * \brief Получить свойства оператора
+ * \param [in] op - оператор
+ * \return - свойства оператора
+ */
+constexpr const OperatorTraits& operatorTraits(Operator op)
+{
+    return OPERATOR_TRAITS[op];
+}
+
+/*!
+ * \class ExpressionNeededInfo
+ * \brief Класс вспомогательной информации для конвертации выражения
+ */
+struct ExpressionNeededInfo {
+    StringInterner atoms;                                            ///< таблица строк идентификаторов выражения, текстовой записи и объявлений
+    DataTypePool types;                                              ///< пул типов данных объявлений
+    DeclarationStore declarations;                             ///< хранилище описаний переменных, функций и пользовательских типов данных
+    std::vector<VariableInfo*> variablesInfo;               ///< набор описаний переменных
+    std::vector<FunctionInfo*> functionsInfo;             ///< набор описаний функций
+    std::vector<CustomDataInfo*> customDataInfo;   ///< набор описаний пользовательских типов данных
+    std::vector<CustomDataInfo*> includedCustomDataInfo; ///< пользовательские типы данных подключенных библиотек (общие, не изменяются)
+    std::vector<std::shared_ptr<const TypeLibrary>> libraries; ///< подключенные библиотеки (удерживаются, пока контекст ссылается на их типы данных)
+    SymbolTable symbols;                                           ///< таблица символов по всем объявлениям
+    SignatureTable signatures;                                  ///< таблица сигнатур функций
+};
+
+class TreeNode;
+class TreeArena;
+
+/*!
+ * \class ChildList
+ * \brief Список дочерних вершин в памяти задания
+ *
+ * Сам список - один указатель на блок памяти задания: количество и вместимость, за которыми следуют элементы.
+ * У листьев блока нет. Память задания передается методам, увеличивающим список (она освобождается целиком,
+ * поэтому прежние блоки не возвращаются)
+ */
+class ChildList {
+public:
+    /*!
+     * \brief Конструктор пустого списка
+     */
+    ChildList() : block(nullptr) {}
+
+    ChildList(const ChildList&) = delete;
+    ChildList& operator=(const ChildList&) = delete;
+
+    /*!
+     * \brief Оператор переноса элементов другого списка (другой список становится пустым)
+     */
+    ChildList& operator=(ChildList&& other){
+        if(this != &other){
+            block = other.block;
+            other.block = nullptr;
+        }
+        return *this;
+    }
+
+    size_t size() const{ return block != nullptr ? block->count : 0; }
+    bool empty() const{ return size() == 0; }
+    TreeNode** begin(){ return data(); }
+    TreeNode** end(){ return data() + size(); }
+    TreeNode* const* begin() const{ return data(); }
+    TreeNode* const* end() const{ return data() + size(); }
+    std::reverse_iterator<TreeNode**> rbegin(){ return std::reverse_iterator<TreeNode**>(end()); }
+    std::reverse_iterator<TreeNode**> rend(){ return std::reverse_iterator<TreeNode**>(begin()); }
+    TreeNode*& operator[](size_t i){ return data()[i]; }
+    TreeNode* operator[](size_t i) const{ return data()[i]; }
+
+    /*!
+     * \brief Метод добавления элемента в конец списка
+     * \param [in] node - элемент
+     * \param [in|out] arena - память задания для блока элементов
+     */
+    void push_back(TreeNode* node, TreeArena& arena){
+        if(size() == capacity()){
+            reserve(capacity() < 2 ? 2 : capacity() * 2, arena);
+        }
+        data()[block->count++] = node;
+    }
+
+    /*!
+     * \brief Метод вставки элемента перед позицией position
+     * \param [in] position - позиция в списке
+     * \param [in] node - элемент
+     * \param [in|out] arena - память задания для блока элементов
+     */
+    void insert(TreeNode** position, TreeNode* node, TreeArena& arena){
+        size_t index = position - data();
+        push_back(node, arena);
+        std::rotate(data() + index, end() - 1, end());
+    }
+
+    /*!
+     * \brief Метод замены содержимого списка элементами диапазона [first, last), не принадлежащего списку
+     * \param [in] first - начало диапазона
+     * \param [in] last - конец диапазона
+     * \param [in|out] arena - память задания для блока элементов
+     */
+    template<class Iterator>
+    void assign(Iterator first, Iterator last, TreeArena& arena){
+        if(block != nullptr){
+            block->count = 0;
+        }
+        if(first == last){
+            return;
+        }
+        reserve((uint32_t)std::distance(first, last), arena);
+        for(; first != last; ++first){
+            data()[block->count++] = *first;
+        }
+    }
+
+    /*!
+     * \brief Метод замены содержимого списка перечисленными элементами
+     * \param [in] nodes - элементы
+     * \param [in|out] arena - память задания для блока элементов
+     */
+    void assign(std::initializer_list<TreeNode*> nodes, TreeArena& arena){
+        assign(nodes.begin(), nodes.end(), arena);
+    }
+
+private:
+    /*!
+     * \brief Заголовок блока элементов, элементы следуют сразу за ним
+     */
+    struct Block {
+        uint32_t count;         ///< количество элементов
+        uint32_t capacity;    ///< вместимость блока
+    };
+
+    Block* block;    ///< блок элементов в памяти задания (nullptr у пустого списка без блока)
+
+    uint32_t capacity() const{ return block != nullptr ? block->capacity : 0; }
+    TreeNode** data(){ return block != nullptr ? (TreeNode**)(block + 1) : nullptr; }
+    TreeNode* const* data() const{ return block != nullptr ? (TreeNode* const*)(block + 1) : nullptr; }
+
+    /*!
+     * \brief Метод увеличения вместимости списка до newCapacity элементов (определен после TreeArena)
+     */
+    void reserve(uint32_t newCapacity, TreeArena& arena);
+};
+
 /*!
 *\class TreeNode
 *\brief Дерево
@@ -471,77 +1356,636 @@ enum Operator
 class TreeNode
 {
 public:
-    std::vector<TreeNode*> nodes;   ///< Список указателей на дочерние вершины
+    ChildList nodes;                          ///< Список указателей на дочерние вершины
+    union {
+        double value;                            ///< Значение вещественной константы
+        long long intValue;                    ///< Значение целочисленной константы или вычисленного целочисленного оператора (foldIntegerConstant)
+        Atom id;                                   ///< Атом идентификатора переменной или функции (читается через identifier)
+    };
+    uint32_t index;                             ///< Номер вершины в памяти задания (индекс в StaticTypeTable и TreeShapePool)
+    int32_t pos;                                 ///< Позиция в обратной польской записи
     NodeType type;                          ///< Тип вершины
-    Operator op;                               ///< Оператор в вершине
-    std::string id;                              ///< Идентификатор переменной
-    double value;                                ///< Значение константы
-    int pos;                                      ///< Позиция в обратной польской записи
+    Operator op;                               ///< Оператор в вершине (arrayItem у операндов)
+    bool marked;                                 ///< Признак метки ошибки пользователя в вершине
+    bool isFoldedConstant;                  ///< Признак вычисленного целочисленного значения вершины
 
     /*!
     *\brief Конструктор по умолчанию
     */
-    TreeNode() { }
+    TreeNode()
+    {
+        init(constant_int, arrayItem, EMPTY_ATOM);
+    }
 
     /*!
     *\brief Создать оператор
     */
-    TreeNode(Operator o, std::vector<TreeNode*> n)
+    TreeNode(Operator o)
     {
-        type = oper;
-        op = o;
-        nodes = n;
+        init(oper, o, EMPTY_ATOM);
     }
 
     /*!
     *\brief Создать переменную
     */
-    TreeNode(std::string varName)
+    TreeNode(Atom varName)
     {
-        type = variable;
-        id = varName;
+        init(variable, arrayItem, varName);
     }
 
     /*!
-        *\brief Создать константу
+        *\brief Создать вещественную константу
         */
     TreeNode(double v)
         {
+            init(constant_float, arrayItem, EMPTY_ATOM);
             value = v;
         }
 
+    /*!
+    *\brief Создать целочисленную константу
+    */
+    TreeNode(long long v)
+    {
+        init(constant_int, arrayItem, EMPTY_ATOM);
+        intValue = v;
+    }
+
+    /*!
+    *\brief Получить значение константы для сообщений
+    *\return Значение константы (0 у остальных вершин)
+    */
+    double numericValue() const
+    {
+        if (type == constant_int)
+            return (double)intValue;
+        return type == constant_float ? value : 0;
+    }
+
+    /*!
+    *\brief Получить атом идентификатора
+    *\return Атом переменной или вызываемой функции (EMPTY_ATOM у остальных вершин, у которых id занят значением)
+    */
+    Atom identifier() const
+    {
+        return type == variable || (type == oper && op == func) ? id : EMPTY_ATOM;
+    }
+
+    /*!
+    *\brief Получить двоичное представление значения константы: у равных констант одного типа оно совпадает
+    *\return Целочисленное значение или биты вещественного (0 у остальных вершин)
+    */
+    uint64_t constantBits() const
+    {
+        uint64_t bits = 0;
+        if (type == constant_int)
+            bits = (uint64_t)intValue;
+        else if (type == constant_float)
+            memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
     /*!
         * \brief Получить текстовое представление оператора на русском языке
         * \return - текстовое представление
         */
-        std::string operatorStringText()
-        {
-            //массив определения строкового представления оператора
-            std::string strs[] = {
-                "доступ к члену массива",  "multable", "arrow", "dot", "divide", "subtract", "addiction", "function call", "pointer"
-            };
-
-            return strs[op];
-        }
+    const char* operatorStringText() const
+    {
+        return operatorTraits(op).text;
+    }
 
     /*!
     * \brief Получить строковое представление оператора
     * \return - строковое представление
     */
-    std::string operatorString(){
-    //массив определения строкового представления оператора
-    std::string strs[] = {"____",  "*", "->", ".", "/", "-", "+", "____", "*"};
-    return strs[op];
+    const char* operatorString() const
+    {
+        return operatorTraits(op).symbol;
     }
 
     /*!
     * \brief Получить количество операндов, необходимых для оператора
     * \return - количество необходимых операторов
     */
-    int operandsCount(){
-    //массив определения количества операндов у оператора
-    int defOperandsCount[] = { 2, 2, 2, 2, 2, 2, 2, -1, 1 };
-    return defOperandsCount[op];
+    int operandsCount() const
+    {
+        return operatorTraits(op).arity;
+    }
+
+private:
+    /*!
+    *\brief Заполнить поля вершины, общие для всех конструкторов
+    */
+    void init(NodeType t, Operator o, Atom i)
+    {
+        type = t;
+        op = o;
+        marked = false;
+        isFoldedConstant = false;
+        value = 0;
+        id = i;
+        pos = 0;
+        index = 0;
+    }
+};
+
+static_assert(sizeof(TreeNode) == 32, "Вершина должна занимать 32 байта: статические типы и структуры поддеревьев хранятся в отдельных таблицах");
+
+/*!
+ * \brief Итеративный обход дерева в прямом порядке: вершина раньше своих дочерних вершин, дочерние вершины слева направо
+ *
+ * Дочерние вершины берутся после обработки вершины, поэтому обработка может их заменить.
+ * Обход использует явный стек, поэтому глубина дерева не ограничена стеком вызовов
+ * \param [in] root - корень дерева
+ * \param [in] visit - обработка вершины, принимающая TreeNode*
+ */
+template<class Visit>
+void forEachPreOrder(TreeNode* root, Visit visit){
+    std::vector<TreeNode*> stack(1, root); //вершины, ожидающие обработки
+    while(!stack.empty()){
+        TreeNode* node = stack.back();
+        stack.pop_back();
+        visit(node);
+        for(int i = (int)node->nodes.size() - 1; i >= 0; i--){
+            stack.push_back(node->nodes[i]);
+        }
+    }
+}
+
+/*!
+ * \brief Итеративный обход дерева в обратном порядке: дочерние вершины слева направо раньше вершины
+ *
+ * Дочерние вершины берутся до обработки их потомков, поэтому обработка вершины может заменить только
+ * ее собственные дочерние вершины (они уже обработаны)
+ * \param [in] root - корень дерева
+ * \param [in] visit - обработка вершины, принимающая TreeNode*
+ */
+template<class Visit>
+void forEachPostOrder(TreeNode* root, Visit visit){
+    std::vector<std::pair<TreeNode*, bool>> stack(1, {root, false}); //вершины и признаки того, что их дочерние вершины уже в стеке
+    while(!stack.empty()){
+        TreeNode* node = stack.back().first;
+        if(stack.back().second){
+            stack.pop_back();
+            visit(node);
+        } else {
+            stack.back().second = true;
+            for(int i = (int)node->nodes.size() - 1; i >= 0; i--){
+                stack.push_back({node->nodes[i], false});
+            }
+        }
+    }
+}
+
+/*!
+ * \brief Результат сравнения пары вершин до сравнения их дочерних вершин
+ */
+enum PairVisit {
+    PAIR_EQUAL,                 ///< вершины равны, дочерние вершины не сравниваются
+    PAIR_DIFFERENT,          ///< вершины отличаются, дочерние вершины не сравниваются
+    PAIR_DESCEND             ///< сравнить попарно дочерние вершины (их количества равны)
+};
+
+/*!
+ * \brief Итеративное попарное сравнение двух деревьев
+ *
+ * Для каждой пары вершин вызывается enter; если он вернул PAIR_DESCEND, попарно сравниваются дочерние
+ * вершины слева направо, а затем вызывается leave с признаками их равенства
+ * \param [in] tree1 - корень первого дерева
+ * \param [in] tree2 - корень второго дерева
+ * \param [in] stopOnDifference - прекратить сравнение на первой отличающейся паре (leave ее предков не вызывается)
+ * \param [in] enter - сравнение пары вершин (TreeNode*, TreeNode*) -> PairVisit
+ * \param [in] leave - сравнение пары вершин по признакам равенства дочерних (TreeNode*, TreeNode*, const std::vector<bool>&) -> bool
+ * \return Равны ли деревья
+ */
+template<class Enter, class Leave>
+bool comparePairsPostOrder(TreeNode* tree1, TreeNode* tree2, bool stopOnDifference, Enter enter, Leave leave){
+    struct Frame {
+        TreeNode* node1;      ///< вершина первого дерева
+        TreeNode* node2;      ///< вершина второго дерева
+        int next;                    ///< номер следующей пары дочерних вершин
+    };
+    std::vector<Frame> frames; //пары вершин, дочерние вершины которых сравниваются
+    std::vector<bool> results; //признаки равенства уже сравненных пар дочерних вершин
+    std::vector<bool> childsEquals; //признаки равенства дочерних вершин текущей пары
+
+    PairVisit first = enter(tree1, tree2);
+    if(first != PAIR_DESCEND){
+        return first == PAIR_EQUAL;
     }
+    frames.push_back({tree1, tree2, 0});
+    while(!frames.empty()){
+        Frame& frame = frames.back();
+        bool equal;
+        if(frame.next < (int)frame.node1->nodes.size()){
+            TreeNode* child1 = frame.node1->nodes[frame.next];
+            TreeNode* child2 = frame.node2->nodes[frame.next];
+            frame.next++;
+            PairVisit visit = enter(child1, child2);
+            if(visit == PAIR_DESCEND){
+                frames.push_back({child1, child2, 0});
+                continue;
+            }
+            equal = visit == PAIR_EQUAL;
+        } else {
+            size_t count = frame.node1->nodes.size();
+            childsEquals.assign(results.end() - count, results.end());
+            results.resize(results.size() - count);
+            equal = leave(frame.node1, frame.node2, childsEquals);
+            frames.pop_back();
+        }
+        if(!equal && stopOnDifference){
+            return false;
+        }
+        results.push_back(equal);
+    }
+    return results.back();
+}
 
+/*!
+ * \class TreeVisitor
+ * \brief Базовый класс прохода по дереву со статической диспетчеризацией по типу вершины
+ *
+ * Проход Pass наследуется от TreeVisitor<Pass, Result> и определяет методы
+ * visitConstant, visitVariable и visitOperator, принимающие TreeNode* и возвращающие Result.
+ * Метод visit выбирает нужный из них без виртуальных вызовов
+ */
+template<class Pass, class Result = void>
+class TreeVisitor {
+public:
+    /*!
+     * \brief Метод обработки вершины проходом
+     * \param [in] node - вершина
+     * \return Результат метода прохода для типа вершины
+     */
+    Result visit(TreeNode* node){
+        Pass& pass = static_cast<Pass&>(*this);
+        switch (node->type)
+        {
+        case constant_int:
+        case constant_float:
+            return pass.visitConstant(node);
+        case variable:
+            return pass.visitVariable(node);
+        default:
+            return pass.visitOperator(node);
+        }
+    }
+
+    /*!
+     * \brief Метод обработки проходом всех вершин дерева в прямом порядке
+     * \param [in] root - корень дерева
+     */
+    void traversePreOrder(TreeNode* root){
+        forEachPreOrder(root, [this](TreeNode* node){ visit(node); });
+    }
+
+    /*!
+     * \brief Метод обработки проходом всех вершин дерева в обратном порядке
+     * \param [in] root - корень дерева
+     */
+    void traversePostOrder(TreeNode* root){
+        forEachPostOrder(root, [this](TreeNode* node){ visit(node); });
+    }
+};
+
+/*!
+ * \class TreeArena
+ * \brief Монотонная память задания для вершин деревьев и их списков дочерних вершин
+ *
+ * Вершины не освобождаются по одной: вся память задания возвращается одним вызовом reset
+ * (или деструктором), поэтому вершины, отброшенные при преобразованиях дерева, не теряются
+ */
+class TreeArena {
+public:
+    TreeArena() : count(0) {}
+    TreeArena(const TreeArena&) = delete;
+    TreeArena& operator=(const TreeArena&) = delete;
+
+    /*!
+     * \brief Метод создания вершины в памяти задания
+     * \param [in] args - аргументы конструктора вершины
+     * \return Указатель на созданную вершину (вершины нумеруются подряд с 0)
+     */
+    template<class... Args>
+    TreeNode* newNode(Args... args){
+        void* place = memory.allocate(sizeof(TreeNode), alignof(TreeNode));
+        TreeNode* node = new (place) TreeNode(args...);
+        node->index = count++;
+        return node;
+    }
+
+    /*!
+     * \brief Метод выделения памяти задания
+     * \param [in] bytes - размер
+     * \param [in] alignment - выравнивание
+     * \return Указатель на выделенную память
+     */
+    void* allocate(size_t bytes, size_t alignment){
+        return memory.allocate(bytes, alignment);
+    }
+
+    /*!
+     * \brief Метод получения количества созданных вершин
+     * \return Количество вершин
+     */
+    uint32_t size() const{
+        return count;
+    }
+
+    /*!
+     * \brief Метод освобождения всех вершин задания (указатели на них становятся недействительными)
+     */
+    void reset(){
+        memory.release();
+        count = 0;
+    }
+
+private:
+    std::pmr::monotonic_buffer_resource memory;    ///< память задания
+    uint32_t count;                                             ///< количество созданных вершин
+};
+
+inline void ChildList::reserve(uint32_t newCapacity, TreeArena& arena){
+    if(newCapacity <= capacity()){
+        return;
+    }
+    Block* grown = (Block*)arena.allocate(sizeof(Block) + newCapacity * sizeof(TreeNode*), alignof(TreeNode*));
+    grown->count = (uint32_t)size();
+    grown->capacity = newCapacity;
+    std::copy(begin(), end(), (TreeNode**)(grown + 1));
+    block = grown;
+}
+
+/*!
+ * \class StaticTypeTable
+ * \brief Статические типы вершин деревьев задания, индексируемые номерами вершин (TreeNode::index)
+ *
+ * Типы нужны только при приведении дерева выражения и поиске места ошибки, поэтому хранятся отдельно от вершин.
+ * Таблица очищается вместе с TreeArena::reset по завершении задания
+ */
+class StaticTypeTable {
+public:
+    /*!
+     * \brief Оператор получения типа вершины для записи (таблица увеличивается до номера вершины)
+     */
+    ResolvedType& operator[](const TreeNode* node){
+        if(node->index >= types.size()){
+            types.resize(node->index + 1, UNRESOLVED_TYPE);
+        }
+        return types[node->index];
+    }
+
+    /*!
+     * \brief Оператор получения типа вершины (UNRESOLVED_TYPE, если тип не определялся)
+     */
+    const ResolvedType& operator[](const TreeNode* node) const{
+        return node->index < types.size() ? types[node->index] : UNRESOLVED_TYPE;
+    }
+
+    /*!
+     * \brief Метод очистки таблицы
+     */
+    void clear(){
+        types.clear();
+    }
+
+private:
+    std::vector<ResolvedType> types;    ///< типы вершин, индекс - номер вершины
+};
+
+/*!
+ * \class TreeShape
+ * \brief Вершина DAG структур поддеревьев: одна на каждое различное поддерево
+ */
+struct TreeShape {
+    uint64_t hash;                                          ///< структурный хэш поддерева
+    NodeType type;                                        ///< тип вершины
+    Operator op;                                             ///< оператор вершины (arrayItem у операндов)
+    Atom id;                                                   ///< атом идентификатора переменной или функции
+    uint64_t value;                                        ///< двоичное представление значения константы (TreeNode::constantBits)
+    std::vector<const TreeShape*> children;  ///< структуры дочерних поддеревьев из того же DAG
+};
+
+/*!
+ * \class TreeShapePool
+ * \brief DAG структур поддеревьев задания
+ *
+ * Каждое различное сочетание (тип, оператор, идентификатор или значение, структуры дочерних поддеревьев)
+ * хранится один раз, поэтому структурно равные поддеревья получают один адрес и сравниваются
+ * сравнением указателей. Структуры вершин хранятся отдельно от вершин, по их номерам (TreeNode::index).
+ * Пул владеет всеми своими структурами и освобождает их вместе с собой или методом clear,
+ * который вызывается вместе с TreeArena::reset по завершении задания
+ */
+class TreeShapePool {
+public:
+    /*!
+     * \brief Конструктор по умолчанию
+     */
+    TreeShapePool(){}
+
+    TreeShapePool(const TreeShapePool&) = delete;
+    TreeShapePool& operator=(const TreeShapePool&) = delete;
+
+    /*!
+     * \brief Метод получения структуры поддерева вершины из пула, структура добавляется в пул при первом обращении
+     * \param [in] node - вершина, корень поддерева
+     * \param [in] shape - структура поддерева, дочерние структуры которой уже взяты из пула (хэш вычисляется методом)
+     * \return Указатель на структуру поддерева в пуле
+     */
+    const TreeShape* intern(const TreeNode* node, TreeShape shape){
+        shape.hash = hashShape(shape);
+        const TreeShape* interned = &shapes.insert(shape, NoValue()).first->key;
+        if(node->index >= nodeShapes.size()){
+            nodeShapes.resize(node->index + 1, nullptr);
+        }
+        nodeShapes[node->index] = interned;
+        return interned;
+    }
+
+    /*!
+     * \brief Метод получения структуры поддерева вершины
+     * \param [in] node - вершина
+     * \return Указатель на структуру поддерева в пуле (nullptr, если поддерево не добавлялось)
+     */
+    const TreeShape* shapeOf(const TreeNode* node) const{
+        return node->index < nodeShapes.size() ? nodeShapes[node->index] : nullptr;
+    }
+
+    /*!
+     * \brief Метод освобождения всех структур (указатели на них становятся недействительными)
+     */
+    void clear(){
+        shapes.clear();
+        nodeShapes.clear();
+    }
+
+    /*!
+     * \brief Метод получения количества структур в пуле
+     * \return Количество структур
+     */
+    int size() const{
+        return shapes.size();
+    }
+
+private:
+    /*!
+     * \brief Хэш структуры (структурный хэш, вычисленный методом intern)
+     */
+    struct TreeShapeHash {
+        static size_t hash(const TreeShape& shape){
+            return (size_t)(shape.hash ^ (shape.hash >> 32));
+        }
+        static bool equal(const TreeShape& first, const TreeShape& second){
+            return first.hash == second.hash && first.type == second.type && first.op == second.op &&
+                   first.id == second.id && first.value == second.value && first.children == second.children;
+        }
+    };
+
+    OpenHashTable<TreeShape, NoValue, TreeShapeHash> shapes;   ///< структуры пула, адреса не меняются при добавлении
+    std::vector<const TreeShape*> nodeShapes;                           ///< структуры поддеревьев вершин, индекс - номер вершины
+
+    /*!
+     * \brief Метод вычисления структурного хэша (FNV-1a по полям вершины и хэшам дочерних структур)
+     */
+    static uint64_t hashShape(const TreeShape& shape){
+        uint64_t hash = 14695981039346656037ULL;
+        hash = (hash ^ (uint64_t)shape.type) * 1099511628211ULL;
+        hash = (hash ^ (uint64_t)shape.op) * 1099511628211ULL;
+        hash = (hash ^ (uint64_t)shape.id) * 1099511628211ULL;
+        hash = (hash ^ shape.value) * 1099511628211ULL;
+        for(size_t i = 0; i < shape.children.size(); i++){
+            hash = (hash ^ shape.children[i]->hash) * 1099511628211ULL;
+        }
+        return hash;
+    }
+};
+
+/*!
+ * \brief Размер буфера файла XML отчета
+ */
+const int XML_REPORT_BUFFER_SIZE = 1 << 16;
+
+/*!
+ * \brief Начало нового файла XML отчета: объявление и открывающий тег корневого элемента
+ */
+const char* const XML_REPORT_HEADER = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<results>\n";
+
+/*!
+ * \brief Закрывающий тег корневого элемента XML отчета, которым заканчивается файл отчета
+ */
+const char* const XML_REPORT_FOOTER = "</results>\n";
+
+/*!
+ * \class XMLReport
+ * \brief Класс потоковой записи результатов работы программы в XML отчет
+ *
+ * Результат каждого задания записывается элементом <result> в корневой элемент <results> файла отчета:
+ * новый результат записывается поверх закрывающего тега корневого элемента, который затем дописывается заново.
+ * Поэтому результаты целого пакета заданий собираются в одном корректном XML файле без построения XML дерева
+ */
+class XMLReport {
+public:
+    /*!
+     * \brief Конструктор, открывающий файл отчета для дозаписи (файл создается, если его нет)
+     * \param [in] reportPath - путь к файлу XML отчета
+     */
+    XMLReport(const std::string& reportPath) : file(openReport(reportPath)), printer(file, false, 1){
+        if(file != nullptr){
+            setvbuf(file, nullptr, _IOFBF, XML_REPORT_BUFFER_SIZE);
+            seekToEndOfResults();
+        }
+    }
+
+    /*!
+     * \brief Деструктор, закрывающий корневой элемент, сбрасывающий буфер и закрывающий файл отчета
+     */
+    ~XMLReport(){
+        if(file != nullptr){
+            fputs(XML_REPORT_FOOTER, file);
+            fclose(file);
+        }
+    }
+
+    XMLReport(const XMLReport&) = delete;
+    XMLReport& operator=(const XMLReport&) = delete;
+
+    /*!
+     * \brief Метод проверки, удалось ли открыть файл отчета
+     * \return Открыт ли файл отчета
+     */
+    bool isOpen() const{
+        return file != nullptr;
+    }
+
+    /*!
+     * \brief Метод записи результата одного задания
+     * \param [in] job - имя задания
+     * \param [in] isEqualTrees - совпало ли дерево текстовой записи пути с деревом выражения
+     * \param [in] errorMessage - сообщение об ошибке пользователя
+     * \param [in] caret - смещение указателя на ошибку пользователя в текстовом представлении пути
+     * \param [in] errorsInfo - ошибки во входных данных
+     * \param [in] strout - текстовое представление пути
+     */
+    void writeResult(const std::string& job, bool isEqualTrees, const QString& errorMessage, int caret, const std::vector<ErrorInfo>& errorsInfo, const std::string& strout){
+        fputs("    ", file); //Отступ элемента результата внутри корневого элемента
+        printer.OpenElement("result");
+        printer.PushAttribute("job", job.c_str());
+        printer.PushAttribute("correct", isEqualTrees && errorsInfo.empty());
+
+        if(!strout.empty()){
+            printer.OpenElement("canonical");
+            printer.PushText(strout.c_str());
+            printer.CloseElement(true);
+        }
+
+        if(!errorMessage.isEmpty()){
+            printer.OpenElement("message");
+            printer.PushAttribute("caret", caret);
+            printer.PushText(errorMessage.toStdString().c_str());
+            printer.CloseElement(true);
+        }
+
+        for(const ErrorInfo& error : errorsInfo){
+            printer.OpenElement("error");
+            printer.PushAttribute("code", error.errorCodeName());
+            printer.PushText(error.createErrorMessage().toStdString().c_str());
+            printer.CloseElement(true);
+        }
+
+        printer.CloseElement();
+        fputc('\n', file);
+    }
+
+private:
+    FILE* file;                                      ///< файл отчета
+    tinyxml2::XMLPrinter printer;          ///< потоковый вывод XML в файл отчета
+
+    /*!
+     * \brief Метод открытия существующего файла отчета для чтения и записи или создания нового
+     */
+    static FILE* openReport(const std::string& reportPath){
+        FILE* report = fopen(reportPath.c_str(), "r+b");
+        return report != nullptr ? report : fopen(reportPath.c_str(), "w+b");
+    }
+
+    /*!
+     * \brief Метод установки позиции записи: на закрывающий тег корневого элемента или после заголовка нового файла
+     */
+    void seekToEndOfResults(){
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        if(size == 0){
+            fputs(XML_REPORT_HEADER, file);
+            return;
+        }
+        long footerSize = (long)strlen(XML_REPORT_FOOTER);
+        char footer[16] = {};
+        if(size >= footerSize && fseek(file, size - footerSize, SEEK_SET) == 0 &&
+           fread(footer, 1, footerSize, file) == (size_t)footerSize && strcmp(footer, XML_REPORT_FOOTER) == 0){
+            fseek(file, size - footerSize, SEEK_SET); //Следующий результат записывается поверх закрывающего тега
+        } else {
+            fseek(file, 0, SEEK_END); //Файл не заканчивается закрывающим тегом: дописать в конец
+        }
+    }
 };
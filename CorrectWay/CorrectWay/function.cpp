@@ -9,6 +9,10 @@
 */
 
 #include "function.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <charconv>
+#include <climits>
 
 void readFileContent (const std::string& filePath, std::string& fileContent, std::vector<ErrorInfo>& errorsInfo){
 
@@ -19,7 +23,7 @@ void readFileContent (const std::string& filePath, std::string& fileContent, std
 
         std::string temp = "";                    // Содержимое строки файла
         while(std::getline(file, temp)) {       // Пока не считали все строки файла
-            fileContent += temp + "\n";      // Считать очередную строку содержимого файла
+            fileContent.append(temp).append("\n"); // Считать очередную строку содержимого файла
         }
         file.close();
     } else {errorsInfo.push_back(ErrorInfo(ERROR_FILE, {QString::fromStdString(filePath)}));}     // Иначе считать, что возникла ошибка при чтении файла
@@ -45,7 +49,121 @@ bool readXMLTreeFromFile(const std::string& xmlFilePath, tinyxml2::XMLDocument&
     return isFileNotEmpty;
 }
 
-const std::vector<VariableInfo*> readVarsInfoFromXML(const tinyxml2::XMLDocument& docXML, std::vector<ErrorInfo>&errorsInfo ){
+TypeLibraryCache& typeLibraryCache(){
+    static TypeLibraryCache cache; // Библиотеки, загруженные за время работы процесса
+    return cache;
+}
+
+/*!
+ * \brief Получить время изменения файла библиотеки (мс)
+ */
+static long long typeLibraryModified(const std::string& libraryPath){
+    return QFileInfo(QString::fromStdString(libraryPath)).lastModified().toMSecsSinceEpoch();
+}
+
+/*!
+ * \brief Проверить, что библиотека и все ее вложенные подключения загружены из текущих версий их файлов
+ */
+static bool isTypeLibraryCurrent(const TypeLibrary* library, const TypeLibraryCache& cache){
+    if(library->modified != typeLibraryModified(library->path)){
+        return false;
+    }
+    for(size_t i = 0; i < library->includes.size(); i++){
+        std::map<std::string, std::shared_ptr<const TypeLibrary>>::const_iterator found = cache.libraries.find(library->includes[i]->path);
+        if(found == cache.libraries.cend() || found->second != library->includes[i] || !isTypeLibraryCurrent(found->second.get(), cache)){
+            return false;
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<const TypeLibrary> loadTypeLibrary(const std::string& libraryPath, std::vector<ErrorInfo>&errorsInfo){
+    TypeLibraryCache& cache = typeLibraryCache();
+    std::lock_guard<std::recursive_mutex> lock(cache.mutex);
+    std::vector<std::string>::iterator loading = std::find(cache.loading.begin(), cache.loading.end(), libraryPath);
+    if(loading != cache.loading.end()){ // Библиотека подключается из собственной загрузки
+        QString cycle; // Цепочка подключений от библиотеки до нее самой
+        for(; loading != cache.loading.end(); ++loading){
+            cycle.append(QString::fromStdString(*loading)).append(" -> ");
+        }
+        errorsInfo.push_back(ErrorInfo(ERROR_FILE_XML_INCLUDE_CYCLE, {cycle.append(QString::fromStdString(libraryPath))}));
+        return nullptr;
+    }
+    std::map<std::string, std::shared_ptr<const TypeLibrary>>::iterator found = cache.libraries.find(libraryPath);
+    if(found != cache.libraries.end() && found->second->errorsInfo.empty() && isTypeLibraryCurrent(found->second.get(), cache)){
+        return found->second;
+    }
+    // Библиотека с ошибками, измененный файл и библиотека со старыми вложенными подключениями читаются заново
+    std::shared_ptr<TypeLibrary> library = std::make_shared<TypeLibrary>();
+    library->path = libraryPath;
+    library->modified = typeLibraryModified(libraryPath);
+    cache.loading.push_back(libraryPath);
+
+    tinyxml2::XMLDocument libraryDoc; // XML дерево библиотеки
+    DeclaredNames declared; // Имена пользовательских типов данных библиотеки и ее вложенных подключений
+    bool isNotEmpty = readXMLTreeFromFile(libraryPath, libraryDoc, library->errorsInfo);
+    if(library->errorsInfo.empty() && isNotEmpty){
+        library->visibleCustomDataInfo = readIncludesFromXML(libraryDoc, libraryPath, declared, library->includes, library->errorsInfo);
+        if(library->errorsInfo.empty()){
+            library->customDataInfo = readCustomDataInfoFromXML(libraryDoc, cache.atoms, cache.types, library->declarations, declared, library->errorsInfo);
+        }
+    }
+
+    if(library->errorsInfo.empty()){
+        // Разрешить типы членов по типам данных библиотеки и ее вложенных подключений
+        library->visibleCustomDataInfo.insert(library->visibleCustomDataInfo.end(), library->customDataInfo.begin(), library->customDataInfo.end());
+        SymbolTable symbols;
+        for(size_t i = 0; i < library->visibleCustomDataInfo.size(); i++){
+            symbols.insert(SymbolInfo{SYMBOL_CUSTOM_DATA, library->visibleCustomDataInfo[i]->id, nullptr, nullptr, library->visibleCustomDataInfo[i], nullptr, nullptr});
+        }
+        buildMemberTables(library->customDataInfo, symbols);
+    } else {
+        library->customDataInfo.clear();
+        library->visibleCustomDataInfo.clear();
+        library->includes.clear();
+    }
+    cache.loading.pop_back();
+    // Прежняя версия остается у контекстов, которые ее подключили, и освобождается вместе с последним из них
+    cache.libraries[libraryPath] = library;
+
+    errorsInfo.insert(errorsInfo.end(), library->errorsInfo.begin(), library->errorsInfo.end());
+    return library;
+}
+
+const std::vector<CustomDataInfo*> readIncludesFromXML(const tinyxml2::XMLDocument& docXML, const std::string& xmlFilePath, DeclaredNames& declared, std::vector<std::shared_ptr<const TypeLibrary>>& libraries, std::vector<ErrorInfo>&errorsInfo){
+    std::vector<CustomDataInfo*> includedInfo; // Результирующий набор пользовательских типов данных подключенных библиотек
+    std::lock_guard<std::recursive_mutex> lock(typeLibraryCache().mutex); // Библиотеки не загружаются другими потоками, пока просматриваются их типы данных
+    QDir xmlDir = QFileInfo(QString::fromStdString(xmlFilePath)).dir(); // Каталог, от которого отсчитываются относительные пути библиотек
+    const tinyxml2::XMLElement* includeNode = docXML.FirstChildElement("include");
+    while(includeNode != nullptr && errorsInfo.empty()){ // Пока не просмотрели все подключения
+        if(includeNode->Attribute("href") == nullptr){
+            errorsInfo.push_back(ErrorInfo(ERROR_FILE_XML_ATTRIBUTE, {"", "include", "href"}));
+            break;
+        }
+        std::string libraryPath = QFileInfo(xmlDir, includeNode->Attribute("href")).absoluteFilePath().toStdString(); // Путь к файлу библиотеки
+        std::shared_ptr<const TypeLibrary> library = loadTypeLibrary(libraryPath, errorsInfo);
+        if(errorsInfo.empty() && std::find(libraries.begin(), libraries.end(), library) == libraries.end()){
+            libraries.push_back(library);
+            for(int i = 0; i < library->visibleCustomDataInfo.size(); i++){
+                CustomDataInfo* custom = library->visibleCustomDataInfo[i];
+                if(declared.customData.insert(custom->id)){
+                    includedInfo.push_back(custom);
+                }
+                // Один и тот же тип данных мог прийти через две библиотеки с общим вложенным подключением
+                else if(std::find(includedInfo.begin(), includedInfo.end(), custom) == includedInfo.end()){
+                    errorsInfo.push_back(ErrorInfo(ERROR_COPY_CUSTOMDATA_NAME, {QString::fromStdString(typeLibraryCache().atoms.text(custom->id))}));
+                }
+            }
+        }
+        includeNode = includeNode->NextSiblingElement("include");
+    }
+    if(!errorsInfo.empty()){
+        includedInfo.clear();
+    }
+    return includedInfo;
+}
+
+const std::vector<VariableInfo*> readVarsInfoFromXML(const tinyxml2::XMLDocument& docXML, StringInterner& atoms, DataTypePool& types, DeclarationStore& declarations, DeclaredNames& declared, std::vector<ErrorInfo>&errorsInfo ){
    std::vector<VariableInfo*> varsInfo; // Результирующий набор описаний переменных
 
    tinyxml2::XMLElement* variablesNode = (tinyxml2::XMLElement*)docXML.FirstChildElement("variables"); //Перейти в тело родительского узла
@@ -55,8 +173,7 @@ const std::vector<VariableInfo*> readVarsInfoFromXML(const tinyxml2::XMLDocument
 
            QString varName;      //Имя переменной
            std::string varTypeStr;   //Тип данных переменной в строковом представлении
-           DataType varType(DT_NONE, {}, NULL, "");       //Тип данных переменной
-           std::string varSizeStr;         //Размер массива в строковом представлении
+           DataType varType(DT_NONE, {}, NULL, EMPTY_ATOM);       //Тип данных переменной
 
            if ( varNode->Attribute("name") != nullptr ){
                varName = varNode->Attribute("name");             // Получить имя переменной
@@ -64,9 +181,9 @@ const std::vector<VariableInfo*> readVarsInfoFromXML(const tinyxml2::XMLDocument
            if ( varNode->Attribute("type") != nullptr ){
                varTypeStr = varNode->Attribute("type") ;          // Получить тип данных переменной в строковом представлении
            } else {errorsInfo.push_back(ErrorInfo(ERROR_FILE_XML_ATTRIBUTE, {"var", "varibles", "type"}));}
-           if ( varNode->Attribute("size") != nullptr ){          // Если в данном родительском узле есть элемент отвечающий за размер массива
-               varSizeStr =  varNode->Attribute("size");  // Получить размер массива
-               varType.convertStrSizeToVectorSize(varSizeStr);
+           int sizeErrorPos = 0;                //Позиция ошибки в размере массива
+           if ( !varType.readArraySizeFromXML(varNode, sizeErrorPos) ){          // Получить размер массива, если переменная является массивом
+               errorsInfo.push_back(ErrorInfo(ERROR_VAR_SIZE, {varName, varNode->Attribute("size"), QString::number(sizeErrorPos)}));
            }
            //Проверить корректность переменной
            if(!checkCorrectVarName(varName)){    //Провеверить корректность имени переменной
@@ -78,9 +195,12 @@ const std::vector<VariableInfo*> readVarsInfoFromXML(const tinyxml2::XMLDocument
            if(!isCorrectCppType(QString::fromStdString(varTypeStr))){       //Проверить корректность типа данных переменной
                errorsInfo.push_back(ErrorInfo(ERROR_VAR_TYPE, {varName, QString::fromStdString(varTypeStr)}));
            }
+           Atom varId = atoms.intern(varName.toStdString()); //Атом имени переменной
+           if(!declared.variables.insert(varId)){     //Проверить не объявлена ли переменная повторно
+               errorsInfo.push_back(ErrorInfo(ERROR_COPY_VAR_NAME, {varName}));
+           }
            if(errorsInfo.empty()){
-               varType.convertStrDTToRealDT(QString::fromStdString(varTypeStr));
-               varsInfo.push_back(new VariableInfo{varName.toStdString(), varType, varTypeStr});
+               varsInfo.push_back(declarations.newVariable(VariableInfo{varId, types.internFromString(QString::fromStdString(varTypeStr), varType.arraySize, atoms), varTypeStr, UNRESOLVED_TYPE}));
                varNode = varNode->NextSiblingElement();                            //Получить описание след. переменной
            }
        }
@@ -91,13 +211,33 @@ const std::vector<VariableInfo*> readVarsInfoFromXML(const tinyxml2::XMLDocument
    return varsInfo;
 }
 
-const std::vector<FunctionInfo*> readFuncInfoFromXML(const tinyxml2::XMLDocument& docXML, std::vector<ErrorInfo>&errorsInfo){
+bool readParamTypesFromXML(const tinyxml2::XMLElement* callableNode, StringInterner& atoms, DataTypePool& types, int& arity, std::vector<const DataType*>& paramTypes, QString& wrongType){
+    arity = ANY_ARITY;
+    paramTypes.clear();
+    const tinyxml2::XMLElement* paramsNode = callableNode->FirstChildElement("params");
+    if(paramsNode == nullptr){ // Список параметров не задан - количество аргументов не проверяется
+        return true;
+    }
+    const tinyxml2::XMLElement* paramNode = paramsNode->FirstChildElement("param");
+    while(paramNode != nullptr){ // Пока не просмотрели все параметры
+        wrongType = paramNode->Attribute("type") != nullptr ? paramNode->Attribute("type") : "";
+        if(!isCorrectCppType(wrongType)){
+            return false;
+        }
+        paramTypes.push_back(types.internFromString(wrongType, {}, atoms));
+        paramNode = paramNode->NextSiblingElement("param");
+    }
+    arity = (int)paramTypes.size();
+    return true;
+}
+
+const std::vector<FunctionInfo*> readFuncInfoFromXML(const tinyxml2::XMLDocument& docXML, StringInterner& atoms, DataTypePool& types, DeclarationStore& declarations, DeclaredNames& declared, std::vector<ErrorInfo>&errorsInfo){
     std::vector<FunctionInfo*> funcInfo; // Результирующий набор описаний функций
     tinyxml2::XMLElement* funcNode = (tinyxml2::XMLElement*)docXML.FirstChildElement("function");
     while (funcNode != nullptr && errorsInfo.empty()){ // Пока не просмотрели все переменные
         QString funcName;                                               //Имя функции
         std::string funcTypeStr;                                            //Тип возвращаемого значения функции в строковом представлении
-        DataType funcType(DT_NONE, {}, NULL, "");       //Тип возвращаемого значения функции
+        DataType funcType(DT_NONE, {}, NULL, EMPTY_ATOM);       //Тип возвращаемого значения функции
         if ( funcNode->Attribute("name") != nullptr ){
         funcName = funcNode->Attribute("name");             // Получить имя функции
         }else {errorsInfo.push_back(ErrorInfo(ERROR_FILE_XML_ATTRIBUTE, {"", "function", "name"}));}
@@ -114,9 +254,21 @@ const std::vector<FunctionInfo*> readFuncInfoFromXML(const tinyxml2::XMLDocument
         if(!isCorrectCppType(QString::fromStdString(funcTypeStr))){       //Проверить корректность типа данных возвращаемого значения функции
             errorsInfo.push_back(ErrorInfo(ERROR_FUNC_RETURNTYPE, {funcName, QString::fromStdString(funcTypeStr)}));
         }
+        int funcArity = ANY_ARITY;                                      //Количество параметров функции
+        std::vector<const DataType*> funcParamTypes;       //Типы данных параметров функции
+        QString wrongParamType;                                         //Некорректный тип данных параметра функции
+        if(!readParamTypesFromXML(funcNode, atoms, types, funcArity, funcParamTypes, wrongParamType)){     //Прочитать необязательный список параметров функции
+            errorsInfo.push_back(ErrorInfo(ERROR_FUNC_PARAM_TYPE, {funcName, wrongParamType}));
+        }
+        Atom funcId = atoms.intern(funcName.toStdString()); //Атом имени функции
+        if(!declared.functions.insert(funcId)){     //Проверить не объявлена ли функция повторно
+            errorsInfo.push_back(ErrorInfo(ERROR_COPY_FUNC_NAME, {funcName}));
+        }
+        if(declared.variables.contains(funcId)){     //Проверить не совпадает ли имя функции с именем переменной (переменные читаются раньше функций)
+            errorsInfo.push_back(ErrorInfo(ERROR_COPY_FUNC_VAR_NAME, {funcName}));
+        }
         if(errorsInfo.empty()){
-            funcType.convertStrDTToRealDT(QString::fromStdString(funcTypeStr));
-            funcInfo.push_back(new FunctionInfo{funcName.toStdString(), funcType, funcTypeStr});
+            funcInfo.push_back(declarations.newFunction(FunctionInfo{funcId, types.internFromString(QString::fromStdString(funcTypeStr), funcType.arraySize, atoms), funcTypeStr, UNRESOLVED_TYPE, funcArity, funcParamTypes}));
             funcNode = funcNode->NextSiblingElement("function");          //Получить описание след. переменной
         }
         }
@@ -127,18 +279,23 @@ const std::vector<FunctionInfo*> readFuncInfoFromXML(const tinyxml2::XMLDocument
 
     }
 
-const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XMLDocument& docXML,  std::vector<ErrorInfo>&errorsInfo){
+const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XMLDocument& docXML, StringInterner& atoms, DataTypePool& types, DeclarationStore& declarations, DeclaredNames& declared, std::vector<ErrorInfo>&errorsInfo){
     QString fieldName;      //Имя поля
     QString nameCustom;  //Имя сложного типа данных
-    DataType fieldType(DT_NONE, {}, NULL, ""); //Тип данных поля в реальном представлении
+    DataType fieldType(DT_NONE, {}, NULL, EMPTY_ATOM); //Тип данных поля в реальном представлении
     std::string strTypeField;    //Тип данных поля в строковом представлении
     MainDataType typeCustom; //Строка содержащая тип данных (class, union, struct)
     QString methodName;  //Имя метода
     std::string returnTypeMethod; //Тип возвращаемого значения метода в строковом представлении
-    DataType methodType(DT_NONE, {}, NULL, ""); //Тип возвращаемого значения метода в реальном представлении
+    DataType methodType(DT_NONE, {}, NULL, EMPTY_ATOM); //Тип возвращаемого значения метода в реальном представлении
+    int methodArity = ANY_ARITY; //Количество параметров метода
+    std::vector<const DataType*> methodParamTypes; //Типы данных параметров метода
+    QString wrongParamType; //Некорректный тип данных параметра метода
     std::vector<VariableInfo*> fieldInfo; // Результирующий набор описаний полей
     std::vector<CustomDataInfo*> customInfo; // Результирующий набор описаний сложных типов данных
     std::vector<FunctionInfo*> methodInfo;// Результирующий набор описаний методов
+    AtomSet fieldNames; //Имена полей текущего пользовательского типа данных
+    AtomSet methodNames; //Имена методов текущего пользовательского типа данных
 
     //Обработать дерево структуры
     tinyxml2::XMLElement* customNodeStruct = (tinyxml2::XMLElement*)docXML.FirstChildElement("struct");
@@ -146,6 +303,11 @@ const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XM
 
         if(customNodeStruct->Attribute("name") != nullptr){
             nameCustom = customNodeStruct->Attribute("name");
+            if(!declared.customData.insert(atoms.intern(nameCustom.toStdString()))){ //Проверить не объявлен ли пользовательский тип данных повторно
+                errorsInfo.push_back(ErrorInfo(ERROR_COPY_CUSTOMDATA_NAME, {nameCustom}));
+            }
+            fieldNames.clear();
+            methodNames.clear();
 
             typeCustom = DT_STRUCT;
             tinyxml2::XMLElement*fieldNode = customNodeStruct->FirstChildElement("field");
@@ -160,6 +322,12 @@ const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XM
 
                 } else {errorsInfo.push_back(ErrorInfo(ERROR_FILE_XML_ATTRIBUTE, {"struct", "field", "typeF"}));}
 
+                fieldType = DataType(DT_NONE, {}, NULL, EMPTY_ATOM); //Сбросить тип данных предыдущего поля
+                int sizeErrorPos = 0; //Позиция ошибки в размере массива
+                if(!fieldType.readArraySizeFromXML(fieldNode, sizeErrorPos)){ //Получить размер массива, если поле является массивом
+                    errorsInfo.push_back(ErrorInfo(ERROR_FIELD_SIZE, {nameCustom, fieldName, fieldNode->Attribute("size"), QString::number(sizeErrorPos)}));
+                }
+
                 if(!checkCorrectVarName(fieldName)){
                     errorsInfo.push_back(ErrorInfo(ERROR_FIELD_NAME, {nameCustom, fieldName}));
                 }
@@ -177,9 +345,12 @@ const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XM
                     errorsInfo.push_back(ErrorInfo(ERROR_CUSTOMDATA_CPP, {nameCustom}));
                 }
 
+                Atom fieldId = atoms.intern(fieldName.toStdString()); //Атом имени поля
+                if(!fieldNames.insert(fieldId)){
+                    errorsInfo.push_back(ErrorInfo(ERROR_COPY_FIELD_NAME, {nameCustom, fieldName}));
+                }
                 if(errorsInfo.empty()){
-                    fieldType.convertStrDTToRealDT(QString::fromStdString(strTypeField));
-                    fieldInfo.push_back(new VariableInfo{fieldName.toStdString(), fieldType, strTypeField});
+                    fieldInfo.push_back(declarations.newVariable(VariableInfo{fieldId, types.internFromString(QString::fromStdString(strTypeField), fieldType.arraySize, atoms), strTypeField, UNRESOLVED_TYPE}));
                     fieldNode = fieldNode->NextSiblingElement("field");
                 }
             }
@@ -207,15 +378,22 @@ const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XM
                     errorsInfo.push_back(ErrorInfo(ERROR_FIELD_TYPE, {nameCustom, QString::fromStdString(returnTypeMethod)}));
                 }
 
+                if(!readParamTypesFromXML(methodNode, atoms, types, methodArity, methodParamTypes, wrongParamType)){
+                    errorsInfo.push_back(ErrorInfo(ERROR_METHOD_PARAM_TYPE, {nameCustom, methodName, wrongParamType}));
+                }
+
+                Atom methodId = atoms.intern(methodName.toStdString()); //Атом имени метода
+                if(!methodNames.insert(methodId)){
+                    errorsInfo.push_back(ErrorInfo(ERROR_COPY_METHOD_NAME, {nameCustom, methodName}));
+                }
                 if(errorsInfo.empty()){
-                    methodType.convertStrDTToRealDT(QString::fromStdString(returnTypeMethod));
-                    methodInfo.push_back(new FunctionInfo{methodName.toStdString(), methodType, returnTypeMethod});
+                    methodInfo.push_back(declarations.newFunction(FunctionInfo{methodId, types.internFromString(QString::fromStdString(returnTypeMethod), methodType.arraySize, atoms), returnTypeMethod, UNRESOLVED_TYPE, methodArity, methodParamTypes}));
                     methodNode = methodNode->NextSiblingElement("method");
                 }
             }
 
             if(errorsInfo.empty()){
-                customInfo.push_back(new CustomDataInfo{nameCustom.toStdString(), typeCustom, fieldInfo, methodInfo});
+                customInfo.push_back(declarations.newCustomData(CustomDataInfo{atoms.intern(nameCustom.toStdString()), typeCustom, fieldInfo, methodInfo, SymbolTable(), SignatureTable()}));
                 fieldInfo.clear();
                 methodInfo.clear();
                 customNodeStruct = customNodeStruct->NextSiblingElement("struct");
@@ -229,6 +407,11 @@ const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XM
 
         if(customNodeClass->Attribute("name") != nullptr){
             nameCustom = customNodeClass->Attribute("name");
+            if(!declared.customData.insert(atoms.intern(nameCustom.toStdString()))){ //Проверить не объявлен ли пользовательский тип данных повторно
+                errorsInfo.push_back(ErrorInfo(ERROR_COPY_CUSTOMDATA_NAME, {nameCustom}));
+            }
+            fieldNames.clear();
+            methodNames.clear();
 
             typeCustom = DT_CLASS;
             tinyxml2::XMLElement*fieldNode = customNodeClass->FirstChildElement("field");
@@ -243,6 +426,12 @@ const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XM
 
                 } else {errorsInfo.push_back(ErrorInfo(ERROR_FILE_XML_ATTRIBUTE, {"class", "field", "typeF"}));}
 
+                fieldType = DataType(DT_NONE, {}, NULL, EMPTY_ATOM); //Сбросить тип данных предыдущего поля
+                int sizeErrorPos = 0; //Позиция ошибки в размере массива
+                if(!fieldType.readArraySizeFromXML(fieldNode, sizeErrorPos)){ //Получить размер массива, если поле является массивом
+                    errorsInfo.push_back(ErrorInfo(ERROR_FIELD_SIZE, {nameCustom, fieldName, fieldNode->Attribute("size"), QString::number(sizeErrorPos)}));
+                }
+
                 if(!checkCorrectVarName(fieldName)){
                     errorsInfo.push_back(ErrorInfo(ERROR_FIELD_NAME, {nameCustom, fieldName}));
                 }
@@ -258,9 +447,12 @@ const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XM
                 if(isCppKeyword(nameCustom)){
                     errorsInfo.push_back(ErrorInfo(ERROR_CUSTOMDATA_CPP, {nameCustom}));
                 }
+                Atom fieldId = atoms.intern(fieldName.toStdString()); //Атом имени поля
+                if(!fieldNames.insert(fieldId)){
+                    errorsInfo.push_back(ErrorInfo(ERROR_COPY_FIELD_NAME, {nameCustom, fieldName}));
+                }
                 if(errorsInfo.empty()){
-                    fieldType.convertStrDTToRealDT(QString::fromStdString(strTypeField));
-                    fieldInfo.push_back(new VariableInfo{fieldName.toStdString(), fieldType, strTypeField});
+                    fieldInfo.push_back(declarations.newVariable(VariableInfo{fieldId, types.internFromString(QString::fromStdString(strTypeField), fieldType.arraySize, atoms), strTypeField, UNRESOLVED_TYPE}));
                     fieldNode = fieldNode->NextSiblingElement("field");
                 }
             }
@@ -288,15 +480,22 @@ const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XM
                     errorsInfo.push_back(ErrorInfo(ERROR_FIELD_TYPE, {nameCustom, QString::fromStdString(returnTypeMethod)}));
                 }
 
+                if(!readParamTypesFromXML(methodNode, atoms, types, methodArity, methodParamTypes, wrongParamType)){
+                    errorsInfo.push_back(ErrorInfo(ERROR_METHOD_PARAM_TYPE, {nameCustom, methodName, wrongParamType}));
+                }
+
+                Atom methodId = atoms.intern(methodName.toStdString()); //Атом имени метода
+                if(!methodNames.insert(methodId)){
+                    errorsInfo.push_back(ErrorInfo(ERROR_COPY_METHOD_NAME, {nameCustom, methodName}));
+                }
                 if(errorsInfo.empty()){
-                    methodType.convertStrDTToRealDT(QString::fromStdString(returnTypeMethod));
-                    methodInfo.push_back(new FunctionInfo{methodName.toStdString(), methodType, returnTypeMethod});
+                    methodInfo.push_back(declarations.newFunction(FunctionInfo{methodId, types.internFromString(QString::fromStdString(returnTypeMethod), methodType.arraySize, atoms), returnTypeMethod, UNRESOLVED_TYPE, methodArity, methodParamTypes}));
                     methodNode = methodNode->NextSiblingElement("method");
                 }
             }
 
             if(errorsInfo.empty()){
-                customInfo.push_back(new CustomDataInfo{nameCustom.toStdString(), typeCustom, fieldInfo, methodInfo});
+                customInfo.push_back(declarations.newCustomData(CustomDataInfo{atoms.intern(nameCustom.toStdString()), typeCustom, fieldInfo, methodInfo, SymbolTable(), SignatureTable()}));
                 fieldInfo.clear();
                 methodInfo.clear();
                 customNodeClass = customNodeClass->NextSiblingElement("class");
@@ -310,6 +509,11 @@ const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XM
 
             if(customNodeUnion->Attribute("name") != nullptr){
                 nameCustom = customNodeUnion->Attribute("name");
+                if(!declared.customData.insert(atoms.intern(nameCustom.toStdString()))){ //Проверить не объявлен ли пользовательский тип данных повторно
+                    errorsInfo.push_back(ErrorInfo(ERROR_COPY_CUSTOMDATA_NAME, {nameCustom}));
+                }
+                fieldNames.clear();
+                methodNames.clear();
 
                 typeCustom = DT_UNION;
                 tinyxml2::XMLElement*fieldNode = customNodeUnion->FirstChildElement("field");
@@ -324,6 +528,12 @@ const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XM
 
                     } else {errorsInfo.push_back(ErrorInfo(ERROR_FILE_XML_ATTRIBUTE, {"union", "field", "typeF"}));}
 
+                    fieldType = DataType(DT_NONE, {}, NULL, EMPTY_ATOM); //Сбросить тип данных предыдущего поля
+                    int sizeErrorPos = 0; //Позиция ошибки в размере массива
+                    if(!fieldType.readArraySizeFromXML(fieldNode, sizeErrorPos)){ //Получить размер массива, если поле является массивом
+                        errorsInfo.push_back(ErrorInfo(ERROR_FIELD_SIZE, {nameCustom, fieldName, fieldNode->Attribute("size"), QString::number(sizeErrorPos)}));
+                    }
+
                     if(!checkCorrectVarName(fieldName)){
                         errorsInfo.push_back(ErrorInfo(ERROR_FIELD_NAME, {nameCustom, fieldName}));
                     }
@@ -339,9 +549,12 @@ const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XM
                     if(isCppKeyword(nameCustom)){
                         errorsInfo.push_back(ErrorInfo(ERROR_CUSTOMDATA_CPP, {nameCustom}));
                     }
+                    Atom fieldId = atoms.intern(fieldName.toStdString()); //Атом имени поля
+                    if(!fieldNames.insert(fieldId)){
+                        errorsInfo.push_back(ErrorInfo(ERROR_COPY_FIELD_NAME, {nameCustom, fieldName}));
+                    }
                     if(errorsInfo.empty()){
-                        fieldType.convertStrDTToRealDT(QString::fromStdString(strTypeField));
-                        fieldInfo.push_back(new VariableInfo{fieldName.toStdString(), fieldType, strTypeField});
+                        fieldInfo.push_back(declarations.newVariable(VariableInfo{fieldId, types.internFromString(QString::fromStdString(strTypeField), fieldType.arraySize, atoms), strTypeField, UNRESOLVED_TYPE}));
                         fieldNode = fieldNode->NextSiblingElement("field");
                     }
                 }
@@ -370,15 +583,22 @@ const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XM
                         errorsInfo.push_back(ErrorInfo(ERROR_FIELD_TYPE, {nameCustom, QString::fromStdString(returnTypeMethod)}));
                     }
 
+                    if(!readParamTypesFromXML(methodNode, atoms, types, methodArity, methodParamTypes, wrongParamType)){
+                        errorsInfo.push_back(ErrorInfo(ERROR_METHOD_PARAM_TYPE, {nameCustom, methodName, wrongParamType}));
+                    }
+
+                    Atom methodId = atoms.intern(methodName.toStdString()); //Атом имени метода
+                    if(!methodNames.insert(methodId)){
+                        errorsInfo.push_back(ErrorInfo(ERROR_COPY_METHOD_NAME, {nameCustom, methodName}));
+                    }
                     if(errorsInfo.empty()){
-                        methodType.convertStrDTToRealDT(QString::fromStdString(returnTypeMethod));
-                        methodInfo.push_back(new FunctionInfo{methodName.toStdString(), methodType, returnTypeMethod});
+                        methodInfo.push_back(declarations.newFunction(FunctionInfo{methodId, types.internFromString(QString::fromStdString(returnTypeMethod), methodType.arraySize, atoms), returnTypeMethod, UNRESOLVED_TYPE, methodArity, methodParamTypes}));
                         methodNode = methodNode->NextSiblingElement("method");
                     }
                 }
 
                 if(errorsInfo.empty()){
-                    customInfo.push_back(new CustomDataInfo{nameCustom.toStdString(), typeCustom, fieldInfo, methodInfo});
+                    customInfo.push_back(declarations.newCustomData(CustomDataInfo{atoms.intern(nameCustom.toStdString()), typeCustom, fieldInfo, methodInfo, SymbolTable(), SignatureTable()}));
                     fieldInfo.clear();
                     methodInfo.clear();
                     customNodeUnion = customNodeUnion->NextSiblingElement("union");
@@ -435,21 +655,42 @@ bool isCppKeyword(const QString &str) {
     return key;
 }
 
-bool isConstant(std::string& str)
+bool isConstant(std::string_view str)
 {
+    int digits = 0; //количество цифр
+    int points = 0; //количество десятичных точек
     for (int i = 0; i < str.length(); i++)
-        if (!isdigit(str[i]) && str[i] != '.')
+    {
+        if (isdigit((unsigned char)str[i]))
+            digits++;
+        else if (str[i] == '.')
+            points++;
+        else
             return false;
+    }
 
-    return true;
+    return digits > 0 && points <= 1;
 }
 
-TreeNode* convertAnExpressionToTree (std::vector<std::string> strs, std::vector <ErrorInfo>& errorsInfo)
+void parseConstant(std::string_view str, TreeNode* node)
+{
+    const char* first = str.data();
+    const char* last = str.data() + str.size();
+    node->type = constant_int;
+    //целое число хранится точно, не помещающееся в 64 бита становится вещественным
+    if (str.find('.') == std::string_view::npos && std::from_chars(first, last, node->intValue).ec == std::errc())
+        return;
+    node->type = constant_float;
+    node->value = 0;
+    std::from_chars(first, last, node->value);
+}
+
+TreeNode* convertAnExpressionToTree (const std::vector<std::string_view>& strs, ExpressionNeededInfo& eni, TreeArena& arena, std::vector <ErrorInfo>& errorsInfo)
 {
     std::vector<TreeNode*> stackT;              //стек вершин дерева
     std::vector<int> stackI;                             //стек индексов
     bool correct = true;
-    std::map<std::string, Operator> defOperator //словарь определения оператора в обратной польской записи
+    static const std::map<std::string_view, Operator> defOperator //словарь определения оператора в обратной польской записи
     {
         {"[]", arrayItem},
         {"*", mul},
@@ -464,12 +705,12 @@ TreeNode* convertAnExpressionToTree (std::vector<std::string> strs, std::vector
     //для всех подстрок...
     for (int i = 0; i < strs.size(); i++)
     {
-        TreeNode* curr = new TreeNode(); //вершина, создаваемая из текущей строки
+        TreeNode* curr = arena.newNode(); //вершина, создаваемая из текущей строки
         curr->pos = i;
         //определить тип подстроки...
-        if(strs[i][0] == '@'){
+        if(!strs[i].empty() && strs[i][0] == '@'){
             if(strs[i].size() > 2 && isdigit(strs[i][1])){
-            QString strBuff = QString::fromStdString(strs[i]);
+            QString strBuff = toQString(strs[i]);
             strBuff.remove("@");
             QRegExp reg("[0-9]*", Qt::CaseSensitive, QRegExp::RegExp2);
             reg.indexIn(strBuff);
@@ -480,51 +721,51 @@ TreeNode* convertAnExpressionToTree (std::vector<std::string> strs, std::vector
                 if (stackT.size() < numArg)
                 {
                     correct =false;
-                    errorsInfo.push_back(ErrorInfo(ERROR_ANALYZE_EXP_MORE_OP, {QString::fromStdString(strs[i])}));
+                    errorsInfo.push_back(ErrorInfo(ERROR_ANALYZE_EXP_MORE_OP, {toQString(strs[i])}));
                 }
-                for(int j = 0; j<numArg; j++){
-                TreeNode* t = stackT.back();
-                curr->nodes.insert(curr->nodes.begin(), t);
-                stackT.pop_back();
-                stackI.pop_back();
-            }
+                //аргументы - верхние элементы стека в исходном порядке
+                int argsCount = std::min<int>(numArg, stackT.size());
+                curr->nodes.assign(stackT.end() - argsCount, stackT.end(), arena);
+                stackT.resize(stackT.size() - argsCount);
+                stackI.resize(stackI.size() - argsCount);
                 curr->op = func;
                 curr->type = oper;
-                curr->id = strBuff.toStdString();
+                curr->id = eni.atoms.intern(strBuff.toStdString());
+                //вызов метода (за ним следует доступ к члену) проверяется по сигнатурам методов при приведении дерева
+                bool isMethodCall = i + 1 < strs.size() && (strs[i + 1] == "." || strs[i + 1] == "->");
+                const SymbolInfo* function = eni.symbols.find(curr->id, SYMBOL_FUNCTION); //объявление функции с таким именем
+                if (!isMethodCall && function != nullptr && eni.signatures.find(curr->id, numArg) == nullptr)
+                    errorsInfo.push_back(ErrorInfo(ERROR_ANALYZE_EXP_FUNC_ARITY, {strBuff, QString::number(numArg), QString::number(function->function->arity)}));
             } else {errorsInfo.push_back(ErrorInfo(ERROR_ANALYZE_EXP_INCORRECT_FUNC_NAME, {strBuff})); correct = false;}
             }
         }
         else if (defOperator.find(strs[i]) != defOperator.cend()) //если подстрока является оператором
         {
             curr->type = oper;
-            curr->op = defOperator[strs[i]];
+            curr->op = defOperator.at(strs[i]);
             //если в стеке осталось элементов меньше, чем количество требуемых операндов для текущего оператора
             if (stackT.size() < curr->operandsCount()){
-                 errorsInfo.push_back(ErrorInfo(ERROR_ANALYZE_EXP_MORE_OP, {QString::fromStdString(strs[i])}));
+                 errorsInfo.push_back(ErrorInfo(ERROR_ANALYZE_EXP_MORE_OP, {toQString(strs[i])}));
                 correct =false;
             }
 
-            //извлечь необходимое количество элементов из стека и сделать их операндами текущего оператора
-            for (int j = 0; j < curr->operandsCount(); j++)
-            {
-                TreeNode* t = stackT.back();
-                curr->nodes.insert(curr->nodes.begin(), t);
-                stackT.pop_back();
-                stackI.pop_back();
-            }
+            //извлечь необходимое количество элементов из стека и сделать их операндами текущего оператора (в исходном порядке)
+            int operandsCount = std::min<int>(curr->operandsCount(), stackT.size());
+            curr->nodes.assign(stackT.end() - operandsCount, stackT.end(), arena);
+            stackT.resize(stackT.size() - operandsCount);
+            stackI.resize(stackI.size() - operandsCount);
         }
         else if (isConstant(strs[i])) //если подстрока является константой
                 {
-                    curr->type = strchr(strs[i].c_str(), '.') != NULL ? constant_float : constant_int;
-                    curr->value = QString::fromStdString(strs[i]).toFloat();
+                    parseConstant(strs[i], curr);
                 }
         else
         {
-            bool isCorrectVarName = checkCorrectVarName(QString::fromStdString(strs[i]));
-            if(!isCorrectVarName){errorsInfo.push_back(ErrorInfo(ERROR_ANALYZE_EXP_TRASH, {QString::fromStdString(strs[i])})); correct =false;}
+            bool isCorrectVarName = checkCorrectVarName(toQString(strs[i]));
+            if(!isCorrectVarName){errorsInfo.push_back(ErrorInfo(ERROR_ANALYZE_EXP_TRASH, {toQString(strs[i])})); correct =false;}
             //считать, что подстрока является названием переменной
             curr->type = variable;
-            curr->id = strs[i];
+            curr->id = eni.atoms.intern(strs[i]);
         }
         if(correct){
             stackT.push_back(curr);
@@ -540,19 +781,39 @@ TreeNode* convertAnExpressionToTree (std::vector<std::string> strs, std::vector
         errorsInfo.push_back(ErrorInfo(ERROR_ANALYZE_EXP_MORE_VAR, {QString::number(stackT.size())}));
     }
 
+    //в стеке не осталось ни одного операнда (ошибки в подстроках уже записаны, иначе выражение пустое)
+    if (stackT.empty())
+    {
+        if (errorsInfo.empty())
+        {
+            QString expression; //выражение, собранное из подстрок
+            for (std::string_view str : strs)
+                expression += (expression.isEmpty() ? "" : " ") + toQString(str);
+            errorsInfo.push_back(ErrorInfo(ERROR_ANALYZE_EXP_NO_OPERANDS, {expression}));
+        }
+        return nullptr;
+    }
+
     //вернуть указатель на единственный оставшийся элемент в стеке
     return stackT[0];
 }
 
-void splitExprToSubstr (const std::string& expStr, std::vector<std::string>& strs)
+void splitExprToSubstr (std::string_view expStr, std::vector<std::string_view>& strs)
 {
-    QString str = QString::fromStdString(expStr);
-
-    QStringList substr = str.split(" ");
-
-    for(int i = 0; i <substr.size(); i++){
-        strs.push_back(substr[i].toStdString());
+    size_t start = 0; //начало очередной подстроки
+    size_t space = expStr.find(' ');
+    while (space != std::string_view::npos)
+    {
+        strs.push_back(expStr.substr(start, space - start));
+        start = space + 1;
+        space = expStr.find(' ', start);
     }
+    strs.push_back(expStr.substr(start));
+}
+
+QString toQString(std::string_view str)
+{
+    return QString::fromUtf8(str.data(), (int)str.size());
 }
 
 bool is_template(const QString &str, templates &temp){
@@ -581,374 +842,494 @@ bool is_template(const QString &str, templates &temp){
     return result;
 }
 
-TreeNode* convertTextToTree(std::string textPath, std::vector <ErrorInfo>& errorsInfo) {
-    //Вытащить строковые представления из текстовой записи, сохранить их и удалить из исходной текстовой записи
-    int bracesDepth = 0;
-    std::vector<TreeNode*> childs;
-    std::vector<int> starts;
-    std::vector<int> ends;
-    for (int i = 0; i < textPath.size(); i++) //анализ поступившей строки с возможным шаблоном
+TreeNode* convertTextToTree(std::string_view textPath, StringInterner& atoms, TreeArena& arena, std::vector <ErrorInfo>& errorsInfo) {
+    //найти для каждой открывающей фигурной скобки парную ей закрывающую
+    std::vector<size_t> closing(textPath.size(), std::string_view::npos);
+    std::vector<size_t> opened; //позиции еще не закрытых скобок
+    for (size_t i = 0; i < textPath.size(); i++)
     {
         if (textPath[i] == '{')
+            opened.push_back(i);
+        else if (textPath[i] == '}' && !opened.empty())
         {
-            if (bracesDepth == 0)
-                starts.push_back(i);
-            bracesDepth++;
+            closing[opened.back()] = i;
+            opened.pop_back();
         }
-        else if (textPath[i] == '}')
+    }
+
+    //текстовые записи, аргументы которых строятся (вместо рекурсии по вложенным аргументам)
+    struct TextFrame {
+        std::string pattern;                     ///< текстовая запись без аргументов
+        std::vector<size_t> args;            ///< позиции открывающих скобок аргументов
+        std::vector<TreeNode*> childs;  ///< вершины аргументов
+        int next;                                        ///< номер следующего строящегося аргумента (аргументы строятся с последнего)
+    };
+    std::vector<TextFrame> frames;
+
+    //выделить из участка текстовой записи аргументы в фигурных скобках, текст между аргументами составляет шаблон
+    auto openFrame = [&](size_t begin, size_t end) {
+        TextFrame frame;
+        size_t patternStart = begin; //начало очередного участка шаблона
+        for (size_t i = begin; i < end; i++)
         {
-            if (bracesDepth == 1)
-                ends.push_back(i + 1);
-            bracesDepth--;
+            if (textPath[i] == '{' && closing[i] < end)
+            {
+                frame.pattern.append(textPath.substr(patternStart, i - patternStart));
+                frame.args.push_back(i);
+                i = closing[i];
+                patternStart = i + 1;
+            }
         }
-    }
+        frame.pattern.append(textPath.substr(patternStart, end - patternStart));
+        frame.childs.resize(frame.args.size());
+        frame.next = (int)frame.args.size() - 1;
+        frames.push_back(std::move(frame));
+    };
 
-    //получение дочерних вершин дерева по массиву строковых представлений аргументов и их извлечение из textPath
-    for (int i = starts.size() - 1; i >= 0; i--)
+    openFrame(0, textPath.size());
+    while (true)
     {
-        std::string arg = textPath.substr(starts[i] + 1, ends[i] - starts[i] - 2);
-        childs.insert(childs.begin(), convertTextToTree(arg, errorsInfo));
-        textPath.erase(textPath.begin() + starts[i], textPath.begin() + ends[i]);
+        TextFrame& frame = frames.back();
+        if (frame.next >= 0) //построить очередной аргумент
+        {
+            size_t open = frame.args[frame.next];
+            openFrame(open + 1, closing[open]);
+            continue;
+        }
+
+        //все аргументы построены - построить вершину и передать ее записи, аргументом которой она является
+        TreeNode* tree = buildTextNode(frame.pattern, frame.childs, atoms, arena, errorsInfo);
+        frames.pop_back();
+        if (frames.empty())
+            return tree;
+        frames.back().childs[frames.back().next--] = tree;
     }
+}
 
-    TreeNode* tree = new TreeNode();
+TreeNode* buildTextNode(const std::string& pattern, std::vector<TreeNode*>& childs, StringInterner& atoms, TreeArena& arena, std::vector <ErrorInfo>& errorsInfo)
+{
+    TreeNode* tree = arena.newNode();
     templates temp;
-    if (is_template(QString::fromStdString(textPath), temp))
+    if (is_template(QString::fromStdString(pattern), temp))
     {
         tree->type = oper;
         switch (temp)
         {
         case oneArray_:
-            tree = new TreeNode(arrayItem, std::vector<TreeNode*> {});
-            tree->nodes.push_back(childs[1]);
-            tree->nodes.push_back(childs[0]);
+            tree = arena.newNode(arrayItem);
+            tree->nodes.push_back(childs[1], arena);
+            tree->nodes.push_back(childs[0], arena);
             break;
          case moreArray_:{
-            tree = new TreeNode(arrayItem, std::vector<TreeNode*>{});
+            tree = arena.newNode(arrayItem);
             TreeNode* curr = tree;
             for (int i = 0; i < childs.size() - 2; i++)
             {
-                curr->nodes.push_back(childs[i]);
+                curr->nodes.push_back(childs[i], arena);
                 childs.erase(childs.begin());
-                TreeNode* leftChild = new TreeNode(arrayItem, std::vector<TreeNode*>{});
-                curr->nodes.insert(curr->nodes.begin(), leftChild);
+                TreeNode* leftChild = arena.newNode(arrayItem);
+                curr->nodes.insert(curr->nodes.begin(), leftChild, arena);
                 curr = leftChild;
             }
-            curr->nodes = std::vector<TreeNode*>{childs[1], childs[0]};
+            curr->nodes.assign({childs[1], childs[0]}, arena);
             break;
         }
         case pointer_:
-            tree = new TreeNode(pointer, std::vector<TreeNode*>{});
-            tree->nodes.push_back(childs[0]);
+            tree = arena.newNode(pointer);
+            tree->nodes.push_back(childs[0], arena);
             break;
 
         case field_:
-            tree = new TreeNode(dot, std::vector<TreeNode*>{});
-            tree->nodes.push_back(childs[1]);
-            tree->nodes.push_back(childs[0]);
+            tree = arena.newNode(dot);
+            tree->nodes.push_back(childs[1], arena);
+            tree->nodes.push_back(childs[0], arena);
             break;
 
         case pointerField_:
-            tree = new TreeNode(arrow, std::vector<TreeNode*>{});
-            tree->nodes.push_back(childs[1]);
-            tree->nodes.push_back(childs[0]);
+            tree = arena.newNode(arrow);
+            tree->nodes.push_back(childs[1], arena);
+            tree->nodes.push_back(childs[0], arena);
             break;
 
         case sum_:
-            tree = new TreeNode(add, std::vector<TreeNode*>{});
-            tree->nodes = childs;
+            tree = arena.newNode(add);
+            tree->nodes.assign(childs.begin(), childs.end(), arena);
             break;
 
         case sub_:
-            tree = new TreeNode(sub, std::vector<TreeNode*>{});
-            tree->nodes = childs;
+            tree = arena.newNode(sub);
+            tree->nodes.assign(childs.begin(), childs.end(), arena);
             break;
 
         case mul_:
-            tree = new TreeNode(mul, std::vector<TreeNode*>{});
-            tree->nodes = childs;
+            tree = arena.newNode(mul);
+            tree->nodes.assign(childs.begin(), childs.end(), arena);
             break;
 
         case div_:{
-            tree = new TreeNode(dv, std::vector<TreeNode*>{});
-            tree->nodes = childs;
+            tree = arena.newNode(dv);
+            tree->nodes.assign(childs.begin(), childs.end(), arena);
             break;
         }
         case funcCall_:{
-            tree = new TreeNode(func, std::vector<TreeNode*>{});
-            tree->nodes = childs;
+            tree = arena.newNode(func);
+            tree->nodes.assign(childs.begin(), childs.end(), arena);
             break;
         }
         case methodCall_:{
-            tree = new TreeNode(dot, std::vector<TreeNode*>{});
-            tree->nodes.push_back(childs[childs.size() - 1]);
+            tree = arena.newNode(dot);
+            tree->nodes.push_back(childs[childs.size() - 1], arena);
             childs.erase(childs.end() - 1);
-            TreeNode* function = new TreeNode(func, std::vector<TreeNode*>{});
-            function->id = childs[0]->id;
+            TreeNode* function = arena.newNode(func);
+            function->id = childs[0]->identifier();
             childs.erase(childs.begin());
-            function->nodes = childs;
-            tree->nodes.push_back(function);
+            function->nodes.assign(childs.begin(), childs.end(), arena);
+            tree->nodes.push_back(function, arena);
             break;
         }
         case methodPointCall_:{
-            tree = new TreeNode(arrow, std::vector<TreeNode*>{});
-            tree->nodes.push_back(childs[childs.size() - 1]);
+            tree = arena.newNode(arrow);
+            tree->nodes.push_back(childs[childs.size() - 1], arena);
             childs.erase(childs.end() - 1);
-            TreeNode* function = new TreeNode(func, std::vector<TreeNode*>{});
-            function->id = childs[0]->id;
+            TreeNode* function = arena.newNode(func);
+            function->id = childs[0]->identifier();
             childs.erase(childs.begin());
-            function->nodes = childs;
-            tree->nodes.push_back(function);
+            function->nodes.assign(childs.begin(), childs.end(), arena);
+            tree->nodes.push_back(function, arena);
             break;
         }
         }
     }
-    else if (isConstant(textPath))
+    else if (isConstant(pattern))
     {
-        tree = new TreeNode(QString::fromStdString(textPath).toFloat());
-        tree->type = strchr(textPath.c_str(), '.') != NULL ? constant_float : constant_int;
+        tree = arena.newNode();
+        parseConstant(pattern, tree);
     }
     else
     {
         //проверка на переменную
-        if (checkCorrectVarName(QString::fromStdString(textPath))){
-            tree = new TreeNode(textPath);
+        if (checkCorrectVarName(QString::fromStdString(pattern))){
+            tree = arena.newNode(atoms.intern(pattern));
     }
         else
-            errorsInfo.push_back(ErrorInfo{ERROR_NO_TEMPLATE, {QString::fromStdString(textPath)}});
+            errorsInfo.push_back(ErrorInfo{ERROR_NO_TEMPLATE, {QString::fromStdString(pattern)}});
     }
 
     return tree;
 }
 
-bool compareTrees(TreeNode* tree1, TreeNode* tree2, std::string& pass)
+bool compareTrees(TreeNode* tree1, TreeNode* tree2, const StringInterner& atoms, const TreeShapePool& shapes, std::string& pass)
 {
-    char buffer[25]; //буфер для преобразования из чисел в строки
+    char buffer[32]; //буфер для преобразования из чисел в строки
+    std::vector<int> lengths; //длины строки pass до пар операторов, дочерние вершины которых сравниваются
 
-    //запомнить длину строки
-    int length = pass.size();
+    //сравнение пары вершин до сравнения их дочерних вершин
+    auto enter = [&](TreeNode* tree1, TreeNode* tree2) -> PairVisit
+    {
+        //структурно равные поддеревья имеют одну структуру в DAG задания
+        if (shapes.shapeOf(tree1) != nullptr && shapes.shapeOf(tree1) == shapes.shapeOf(tree2))
+            return PAIR_EQUAL;
 
-    //приклеить к pass стрелку
-    pass.append(" -> ");
+        //запомнить длину строки
+        int length = pass.size();
 
-    //проверить равенство типов вершин
-    if (tree1->type != tree2->type)
-    {
-        pass.append("different node types: exp ");
-        pass.append(_itoa((int)tree1->type, buffer, 10));
-        pass.append(", act: ");
-        pass.append(_itoa((int)tree2->type, buffer, 10));
-        return false;
-    }
+        //приклеить к pass стрелку
+        pass.append(" -> ");
 
-    if (tree1->type == constant_int || tree1->type == constant_float) //если эти вершины являются константами
-    {
-        //проверить равенство значений констант
-        if (tree1->value != tree2->value)
+        //проверить равенство типов вершин
+        if (tree1->type != tree2->type)
         {
-            //приклеить к pass представление константы
-            pass.append(_itoa(tree2->value, buffer, 10));
-            return false;
+            pass.append("different node types: exp ");
+            pass.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), (int)tree1->type).ptr);
+            pass.append(", act: ");
+            pass.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), (int)tree2->type).ptr);
+            return PAIR_DIFFERENT;
         }
-    }
-    else if (tree1->type == variable) //если эти вершины являются переменными
-    {
-        //проверить равенство идентификаторов переменных
-        if (tree1->id != tree2->id)
+
+        if (tree1->type == constant_int || tree1->type == constant_float) //если эти вершины являются константами
         {
-            //приклеить к pass представление переменной
-            pass.append(tree2->id);
-            return false;
+            //проверить равенство значений констант
+            if (tree1->constantBits() != tree2->constantBits())
+            {
+                //приклеить к pass представление константы (целое без усечения, вещественное в кратчайшей точной записи)
+                std::to_chars_result written = tree2->type == constant_int ? std::to_chars(buffer, buffer + sizeof(buffer), tree2->intValue)
+                                                                           : std::to_chars(buffer, buffer + sizeof(buffer), tree2->value);
+                pass.append(buffer, written.ptr);
+                return PAIR_DIFFERENT;
+            }
         }
-    }
-    else //эти вершины являются операторами
-    {
-        //приклеить к pass представление оператора
-        pass.append(tree2->operatorString());
+        else if (tree1->type == variable) //если эти вершины являются переменными
+        {
+            //проверить равенство идентификаторов переменных
+            if (tree1->id != tree2->id)
+            {
+                //приклеить к pass представление переменной
+                pass.append(atoms.text(tree2->id));
+                return PAIR_DIFFERENT;
+            }
+        }
+        else //эти вершины являются операторами
+        {
+            //приклеить к pass представление оператора
+            pass.append(tree2->operatorString());
 
-        //проверить равенство операторов
-        if (tree1->op != tree2->op)
-            return false;
+            //проверить равенство операторов
+            if (tree1->op != tree2->op)
+                return PAIR_DIFFERENT;
 
-        //проверить равенство количеств дочерних вершин
-        if (tree1->nodes.size() != tree2->nodes.size())
-            return false;
+            //проверить равенство количеств дочерних вершин
+            if (tree1->nodes.size() != tree2->nodes.size())
+                return PAIR_DIFFERENT;
 
-        //проверить попарное равенство всех дочерних вершин
-        for (int i = 0; i < tree1->nodes.size(); i++)
-            if (!compareTrees(tree1->nodes[i], tree2->nodes[i], pass))
-                return false;
-    }
+            //проверить попарное равенство всех дочерних вершин
+            lengths.push_back(length);
+            return PAIR_DESCEND;
+        }
+
+        //удалить из строки новое содержимое
+        pass.erase(pass.begin() + length, pass.end());
+        return PAIR_EQUAL;
+    };
 
-    //удалить из строки новое содержимое
-    pass.erase(pass.begin() + length, pass.end());
+    //все дочерние вершины пары операторов равны - удалить из строки содержимое пары
+    auto leave = [&](TreeNode*, TreeNode*, const std::vector<bool>&) -> bool
+    {
+        pass.erase(pass.begin() + lengths.back(), pass.end());
+        lengths.pop_back();
+        return true;
+    };
 
-    return true;
+    return comparePairsPostOrder(tree1, tree2, true, enter, leave);
 }
 
 void getNearDiffOperands(TreeNode* tree, std::vector<TreeNode*>& operands)
 {
-    //для всех дочерних вершин
-    for (int i = 0; i < tree->nodes.size(); i++)
+    //дочерние вершины, ожидающие просмотра (верхняя - самая левая)
+    std::vector<TreeNode*> stack(tree->nodes.rbegin(), tree->nodes.rend());
+    while (!stack.empty())
     {
-        //если дочерняя вершина является равным исходному оператором
-        if (tree->nodes[i]->type == oper && tree->nodes[i]->op == tree->op)
-            getNearDiffOperands(tree->nodes[i], operands); //рекурсивный вызов
+        TreeNode* node = stack.back();
+        stack.pop_back();
+        //если вершина является равным исходному оператором, просмотреть ее дочерние вершины на ее месте
+        if (node->type == oper && node->op == tree->op)
+            stack.insert(stack.end(), node->nodes.rbegin(), node->nodes.rend());
         else //иначе добавить вершину в список отличающихся операндов
-            operands.push_back(tree->nodes[i]);
+            operands.push_back(node);
     }
 }
 
-void conv_combineAddMulOperators(TreeNode* tree)
-{
-    //если текущая вершина является оператором сложения или умножения
-    if (tree->op == add || tree->op == mul)
+/*!
+ * \brief Проход объединения вложенных одноименных коммутативных операторов
+ */
+class CombineCommutativePass : public TreeVisitor<CombineCommutativePass> {
+public:
+    CombineCommutativePass(TreeArena& arena) : arena(arena) {}
+
+    void visitConstant(TreeNode*) {}
+    void visitVariable(TreeNode*) {}
+
+    void visitOperator(TreeNode* tree)
     {
-        //получить список операндов, которые отличаются от искомого оператора
-        std::vector<TreeNode*> operands;
-        getNearDiffOperands(tree, operands);
+        //если текущая вершина является коммутативным оператором
+        if (operatorTraits(tree->op).commutative)
+        {
+            //получить список операндов, которые отличаются от искомого оператора
+            operands.clear();
+            getNearDiffOperands(tree, operands);
 
-        //сделать полученные операнды операндами текущей вершины
-        tree->nodes = operands;
+            //сделать полученные операнды операндами текущей вершины (дочерние вершины обрабатываются после нее)
+            tree->nodes.assign(operands.begin(), operands.end(), arena);
+        }
     }
 
-    //проделать то же самое для всех дочерних вершин
-    for (int i = 0; i < tree->nodes.size(); i++)
-        conv_combineAddMulOperators(tree->nodes[i]);
-}
+private:
+    TreeArena& arena;                          ///< память задания для операндов объединенных операторов
+    std::vector<TreeNode*> operands;    ///< буфер операндов, общий для всех вершин прохода
+};
 
-void conv_sort(TreeNode* tree)
+void conv_combineAddMulOperators(TreeNode* tree, TreeArena& arena)
 {
-    std::vector<std::string> buf;
+    CombineCommutativePass(arena).traversePreOrder(tree);
+}
 
-    //отсортировать все дочерние вершины
-    for (int i = 0; i < tree->nodes.size(); i++)
-        conv_sort(tree->nodes[i]);
+/*!
+ * \brief Сравнить собственные поля вершин в каноническом порядке (без учета операндов)
+ * \return Отрицательное число, 0 или положительное число
+ */
+static int compareCanonicalNodes(const TreeNode* first, const TreeNode* second, const StringInterner& atoms)
+{
+    //ранг вида вершины: константы, переменные, операторы
+    auto kindRank = [](const TreeNode* node) { return node->type == oper ? 2 : node->type == variable ? 1 : 0; };
+    if (kindRank(first) != kindRank(second))
+        return kindRank(first) - kindRank(second);
 
-    //если текущий оператор является коммутативным
-    if (tree->op == add || tree->op == mul)
+    if (first->type == constant_int || first->type == constant_float)
     {
-        //получить строковые представления всех дочерних вершин
-        std::vector<std::string> strs;
-        for (int i = 0; i < tree->nodes.size(); i++)
-        {
-            std::string str; //строковое представление очередной вершины
-            convertTreeToString(tree->nodes[i], str);
-            strs.push_back(str);
-        }
-        //применить пузырьковую сортировку для списка полученных строк, параллельно с этим сортируя дочерние вершины
-        for (int j = 0; j < strs.size(); j++) //повторить столько раз, сколько строк в списке
-            for (int i = 0; i < strs.size() - 1; i++) //для всех пар соседних строк
-                if (strs[i] > strs[i + 1]) //если строки нарушают порядок сортировки
-                {
-                    std::swap(strs[i], strs[i + 1]); //поменять строки местами
-                    std::swap(tree->nodes[i], tree->nodes[i + 1]); //поменять соответствующие им дочерние вершины местами
-                }
+        if (first->numericValue() != second->numericValue())
+            return first->numericValue() < second->numericValue() ? -1 : 1;
+        if (first->type != second->type)
+            return first->type == constant_int ? -1 : 1;
+        //значения больших целых чисел могут совпасть после перевода в double
+        if (first->type == constant_int && first->intValue != second->intValue)
+            return first->intValue < second->intValue ? -1 : 1;
+        return 0;
     }
-}
 
-void checkENIOncopyInXML(ExpressionNeededInfo& eni, std::vector<ErrorInfo>& errorList)
-{
-    //проверка совпадений по переменным
-    std::vector<std::string> examples;
-    for (int i = 0; i < eni.variablesInfo.size(); i++)
+    if (first->type == oper)
     {
-        //проверить наличие текущего id в списке examples
-        for (int j = 0; j < examples.size(); j++)
-            if (eni.variablesInfo[i]->id == examples[j])
-            {
-                //ОШИБКА совпадения имён переменных
-                errorList.push_back(ErrorInfo(ERROR_COPY_VAR_NAME, { QString::fromStdString(examples[j]) }));
-            }
-
-        //добавить новый example
-        examples.push_back(eni.variablesInfo[i]->id);
+        if (first->op != second->op)
+            return first->op < second->op ? -1 : 1;
+        if (first->nodes.size() != second->nodes.size())
+            return first->nodes.size() < second->nodes.size() ? -1 : 1;
+        if (first->op != func)
+            return 0;
     }
-    examples.clear();
 
-    //проверка совпадений по функциям
-    for (int i = 0; i < eni.functionsInfo.size(); i++)
-    {
-        //проверить наличие текущего id в списке examples
-        for (int j = 0; j < examples.size(); j++)
-            if (eni.functionsInfo[i]->id == examples[j])
-            {
-                //ОШИБКА совпадения имён функций
-                errorList.push_back( ErrorInfo(ERROR_COPY_FUNC_NAME, { QString::fromStdString(examples[j]) }));
-            }
+    //имя переменной или вызываемой функции
+    return first->id == second->id ? 0 : atoms.text(first->id).compare(atoms.text(second->id));
+}
 
-        //добавить новый example
-        examples.push_back(eni.functionsInfo[i]->id);
-    }
-    examples.clear();
+/*!
+ * \brief Количество первых вершин прямого обхода поддерева, входящих в его ключ сортировки
+ */
+const int CANONICAL_PREFIX = 4;
 
-    //проверка совпадений по функциям
-    for (int i = 0; i < eni.functionsInfo.size(); i++)
-        for (int j = 0; j < eni.variablesInfo.size(); j++)
-            if (eni.functionsInfo[i]->id == eni.variablesInfo[i]->id)
-            {
-                //ОШИБКА совпадения имени переменной и имени функции
-                errorList.push_back(ErrorInfo(ERROR_COPY_FUNC_VAR_NAME, { QString::fromStdString(eni.functionsInfo[i]->id)}));
-            }
+/*!
+ * \brief Ключ сортировки поддерева, вычисляемый один раз из ключей его дочерних поддеревьев
+ */
+struct CanonicalKey {
+    TreeNode* node;                                        ///< корень поддерева
+    const TreeNode* prefix[CANONICAL_PREFIX];  ///< первые вершины поддерева в прямом порядке обхода (операнды уже упорядочены)
+    int length;                                               ///< количество вершин в prefix
+    uint64_t hash;                                          ///< структурный хэш поддерева
+};
 
-    //проверить customData
-    for (int i = 0; i < eni.customDataInfo.size(); i++)
+/*!
+ * \brief Сравнить поддеревья по вершинам прямого обхода до первой различающейся вершины
+ * \param [in|out] pending - буфер пар вершин, ожидающих сравнения
+ * \return Отрицательное число, 0 или положительное число
+ */
+static int compareCanonicalTrees(const TreeNode* first, const TreeNode* second, const StringInterner& atoms, std::vector<std::pair<const TreeNode*, const TreeNode*>>& pending)
+{
+    pending.assign(1, {first, second});
+    while (!pending.empty())
     {
-        //проверить наличие текущего id в списке examples
-        for (int j = 0; j < examples.size(); j++)
-            if (eni.customDataInfo[i]->id == examples[j])
-            {
-                //ОШИБКА совпадения имён пользовательского типа данных
-                errorList.push_back(ErrorInfo(ERROR_COPY_CUSTOMDATA_NAME, { QString::fromStdString(examples[j]) }));
-            }
+        std::pair<const TreeNode*, const TreeNode*> nodes = pending.back();
+        pending.pop_back();
+        int order = compareCanonicalNodes(nodes.first, nodes.second, atoms);
+        if (order != 0)
+            return order;
+        //равные вершины имеют одинаковое количество операндов; левый операнд сравнивается первым
+        for (size_t i = nodes.first->nodes.size(); i-- > 0;)
+            pending.push_back({nodes.first->nodes[i], nodes.second->nodes[i]});
+    }
+    return 0;
+}
 
-        //добавить новый example
-        examples.push_back(eni.customDataInfo[i]->id);
+/*!
+ * \brief Сравнить ключи сортировки поддеревьев
+ *
+ * Прямой обход однозначно задает дерево (количество операндов входит в вершину), поэтому поддеревья,
+ * различающиеся в первых CANONICAL_PREFIX вершинах, упорядочиваются без обхода. Совпадающие в них поддеревья
+ * с равным структурным хэшем считаются равными, а остальные сравниваются по прямому обходу целиком
+ * \param [in|out] pending - буфер пар вершин для сравнения поддеревьев целиком
+ * \return Отрицательное число, 0 или положительное число
+ */
+static int compareCanonicalKeys(const CanonicalKey& first, const CanonicalKey& second, const StringInterner& atoms, std::vector<std::pair<const TreeNode*, const TreeNode*>>& pending)
+{
+    for (int i = 0; i < first.length && i < second.length; i++)
+    {
+        int order = compareCanonicalNodes(first.prefix[i], second.prefix[i], atoms);
+        if (order != 0)
+            return order;
     }
-    examples.clear();
+    if (first.hash == second.hash)
+        return 0;
+    return compareCanonicalTrees(first.node, second.node, atoms, pending);
+}
 
-    //проверить поля в customData
-    for (int i = 0; i < eni.customDataInfo.size(); i++)
+/*!
+ * \brief Проход сортировки операндов коммутативных операторов
+ *
+ * Ключи поддеревьев вычисляются в обратном порядке обхода: ключи дочерних вершин лежат на вершине стека keys
+ * к моменту обработки их родителя, поэтому каждое поддерево обходится один раз
+ */
+class SortCommutativePass : public TreeVisitor<SortCommutativePass> {
+public:
+    SortCommutativePass(const StringInterner& atoms) : atoms(atoms) {}
+
+    void visitConstant(TreeNode* tree) { pushKey(tree, 0); }
+    void visitVariable(TreeNode* tree) { pushKey(tree, 0); }
+
+    void visitOperator(TreeNode* tree)
     {
-        for (int k = 0; k < eni.customDataInfo[i]->fields.size(); k++)
+        //дочерние вершины уже отсортированы: обход в обратном порядке
+        //если текущий оператор является коммутативным, упорядочить его операнды (равные операнды сохраняют исходный порядок)
+        size_t count = tree->nodes.size();
+        if (operatorTraits(tree->op).commutative)
         {
-            //проверить наличие текущего id в списке examples
-            for (int j = 0; j < examples.size(); j++)
-                if (eni.customDataInfo[i]->fields[k]->id == examples[j])
-                {
-                    //ОШИБКА совпадения имён пользовательского типа данных
-                    errorList.push_back(ErrorInfo(ERROR_COPY_FIELD_NAME, { QString::fromStdString(eni.customDataInfo[i]->id), QString::fromStdString(examples[j]) }));
-                }
-
-            //добавить новый example
-            examples.push_back(eni.customDataInfo[i]->fields[k]->id);
+            std::stable_sort(keys.end() - count, keys.end(), [this](const CanonicalKey& first, const CanonicalKey& second) {
+                return compareCanonicalKeys(first, second, atoms, pending) < 0;
+            });
+            for (size_t i = 0; i < count; i++)
+                tree->nodes[i] = keys[keys.size() - count + i].node;
         }
-        examples.clear();
+        pushKey(tree, count);
     }
 
-    //проверить методы в customData
-    for (int i = 0; i < eni.customDataInfo.size(); i++)
+private:
+    const StringInterner& atoms;    ///< атомы идентификаторов контекста
+    std::vector<CanonicalKey> keys;  ///< ключи обработанных поддеревьев, родитель которых еще не обработан
+    std::vector<std::pair<const TreeNode*, const TreeNode*>> pending; ///< буфер сравнения поддеревьев целиком
+
+    /*!
+     * \brief Заменить ключи count дочерних вершин на вершине стека ключом поддерева вершины tree
+     */
+    void pushKey(TreeNode* tree, size_t count)
     {
-        for (int k = 0; k < eni.customDataInfo[i]->fields.size(); k++)
+        CanonicalKey key; //ключ поддерева
+        key.node = tree;
+        key.prefix[0] = tree;
+        key.length = 1;
+        uint64_t hash = 14695981039346656037ULL;
+        hash = (hash ^ (uint64_t)tree->type) * 1099511628211ULL;
+        hash = (hash ^ (uint64_t)(tree->type == oper ? tree->op : arrayItem)) * 1099511628211ULL;
+        //хэш зависит от имени, а не от номера атома, который определяется порядком объявлений
+        if (tree->type == variable || (tree->type == oper && tree->op == func))
+            for (char c : atoms.text(tree->id))
+                hash = (hash ^ (uint8_t)c) * 1099511628211ULL;
+        hash = (hash ^ tree->constantBits()) * 1099511628211ULL;
+        //прямой обход поддерева продолжается прямыми обходами операндов слева направо
+        for (size_t i = keys.size() - count; i < keys.size(); i++)
         {
-            //проверить наличие текущего id в списке examples
-            for (int j = 0; j < examples.size(); j++)
-                if (eni.customDataInfo[i]->fields[k]->id == examples[j])
-                {
-                    //ОШИБКА совпадения имён пользовательского типа данных
-                    errorList.push_back(ErrorInfo(ERROR_COPY_METHOD_NAME, { QString::fromStdString(eni.customDataInfo[i]->id), QString::fromStdString(examples[j]) }));
-                }
-
-            //добавить новый example
-            examples.push_back(eni.customDataInfo[i]->fields[k]->id);
+            for (int j = 0; j < keys[i].length && key.length < CANONICAL_PREFIX; j++)
+                key.prefix[key.length++] = keys[i].prefix[j];
+            hash = (hash ^ keys[i].hash) * 1099511628211ULL;
         }
-        examples.clear();
+        key.hash = hash;
+        keys.resize(keys.size() - count);
+        keys.push_back(key);
     }
+};
+
+void conv_sort(TreeNode* tree, const StringInterner& atoms)
+{
+    SortCommutativePass(atoms).traversePostOrder(tree);
 }
 
-bool compareTextTreeAndExpressionTree(TreeNode* tree1, TreeNode* tree2, QString& errorString, ExpressionNeededInfo& eni, const bool oneNode)
+/*!
+ * \brief Сравнить пару вершин дерева по текстовой записи и дерева выражения до сравнения их дочерних вершин
+ * \param [in] tree1 - вершина дерева по текстовой записи
+ * \param [in|out] tree2 - вершина дерева выражения (помечается при ошибке)
+ * \param [out] errorString - сообщение об ошибке
+ * \param [in] oneNode - является ли одно из деревьев узлом
+ * \return Результат сравнения пары вершин
+ */
+static PairVisit compareTextAndExpressionNodes(TreeNode* tree1, TreeNode* tree2, const TreeShapePool& shapes, QString& errorString, const bool oneNode)
 {
-    char buffer[25]; //буфер для преобразования из чисел в строки
+    //структурно равные поддеревья имеют одну структуру в DAG задания
+    if (shapes.shapeOf(tree1) != nullptr && shapes.shapeOf(tree1) == shapes.shapeOf(tree2))
+        return PAIR_EQUAL;
 
     //проверить равенство типов вершин
     if (tree1->type != tree2->type)
@@ -969,21 +1350,21 @@ bool compareTextTreeAndExpressionTree(TreeNode* tree1, TreeNode* tree2, QString&
              break;
         }
 
-        tree2->id.insert(tree2->id.begin(), '#');
-        return false;
+        tree2->marked = true;
+        return PAIR_DIFFERENT;
     }
 
     if (tree1->type == constant_int || tree1->type == constant_float) //если эти вершины являются константами
     {
         //проверить равенство значений констант
-        if (tree1->value != tree2->value)
+        if (tree1->constantBits() != tree2->constantBits())
         {
             if (oneNode)
             {
-                tree2->id.insert(tree2->id.begin(), '#');
+                tree2->marked = true;
                 errorString = "В указанной позиции константы отличаются";
             }
-            return false;
+            return PAIR_DIFFERENT;
         }
     }
     else if (tree1->type == variable) //если эти вершины являются переменными
@@ -993,10 +1374,10 @@ bool compareTextTreeAndExpressionTree(TreeNode* tree1, TreeNode* tree2, QString&
         {
             if (oneNode)
             {
-                tree2->id.insert(tree2->id.begin(), '#');
+                tree2->marked = true;
                 errorString = "В указанной позиции переменные отличаются";
             }
-            return false;
+            return PAIR_DIFFERENT;
         }
     }
     else //эти вершины являются операторами
@@ -1004,128 +1385,359 @@ bool compareTextTreeAndExpressionTree(TreeNode* tree1, TreeNode* tree2, QString&
         //проверить равенство операторов
         if (tree1->op != tree2->op)
         {
-            tree2->id.insert(tree2->id.begin(), '#');
-            errorString = "Указанный оператор выбран неправильно. Должен быть " + QString::fromStdString(tree1->operatorStringText());
-            return false;
+            tree2->marked = true;
+            errorString = "Указанный оператор выбран неправильно. Должен быть " + QString::fromUtf8(tree1->operatorStringText());
+            return PAIR_DIFFERENT;
         }
 
         //проверить равенство количеств дочерних вершин
         if (tree1->nodes.size() != tree2->nodes.size())
         {
-            tree2->id.insert(tree2->id.begin(), '#');
+            tree2->marked = true;
             errorString = "Количество операндов у указанного оператора неправильно. Должен(-но) быть " + QString::number(tree1->nodes.size()) + "операнд(-ов)";
-            return false;
+            return PAIR_DIFFERENT;
         }
 
-        //получить признаки равенства для каждой дочерней вершины
-        std::vector<bool> childsEquals;
-        //проверить попарное равенство всех дочерних вершин
-        for (int i = 0; i < tree1->nodes.size(); i++)
-            childsEquals.push_back(compareTextTreeAndExpressionTree(tree1->nodes[i], tree2->nodes[i], errorString, eni, oneNode));
+        //сравнить попарно дочерние вершины
+        return PAIR_DESCEND;
+    }
+    return PAIR_EQUAL;
+}
 
-        //проверить и определить ошибку
-        bool allCorrect = true; //изначально считать, что всё совпало
-        for (int i = 0; i < tree1->nodes.size(); i++){
-            if(!childsEquals[i])
-                allCorrect = false;
-        }
+/*!
+ * \brief Определить ошибку в паре операторов по признакам равенства их дочерних вершин
+ * \param [in] tree1 - оператор дерева по текстовой записи
+ * \param [in] tree2 - оператор дерева выражения
+ * \param [in] childsEquals - признаки равенства дочерних вершин
+ * \param [out] errorString - сообщение об ошибке
+ * \param [in] eni - необходимая информация
+ * \param [in] staticTypes - статические типы вершин дерева выражения
+ * \return Равны ли операторы
+ */
+static bool explainOperatorDifference(TreeNode* tree1, TreeNode* tree2, const std::vector<bool>& childsEquals, QString& errorString, ExpressionNeededInfo& eni, const StaticTypeTable& staticTypes)
+{
+    //проверить и определить ошибку
+    bool allCorrect = true; //изначально считать, что всё совпало
+    for (int i = 0; i < childsEquals.size(); i++){
+        if(!childsEquals[i])
+            allCorrect = false;
+    }
 
 
-        if (!allCorrect)
+    if (!allCorrect)
+    {
+        switch (tree2->op)
         {
-            switch (tree2->op)
+        case arrayItem:
+            if (!childsEquals[0])
+                errorString = "В указанном месте идёт обращение к иному массиву. Должен быть массив " + QString::fromStdString(eni.atoms.text(tree1->nodes[0]->identifier()));
+            else if (!childsEquals[1])
+                errorString = "В указанном месте идёт обращение к иной ячейке массива. Должно быть обращение к ячейке " + QString::number(tree1->nodes[1]->numericValue());
+            break;
+        case mul:
+            if (!childsEquals[0])
+                errorString = "Левый множитель неправильный. Должен быть" + QString::number(tree1->nodes[0]->numericValue());
+            else if (!childsEquals[1])
+                errorString = "Правый множитель неправильный. Должен быть" + QString::number(tree1->nodes[1]->numericValue());
+            break;
+        case arrow:
+            if (!childsEquals[0])
+                errorString = "В указанной операции идет обращение к иной пользовательской структуре данных. Имя необходимой структуры данных: " + QString::fromStdString(eni.atoms.text(tree1->nodes[0]->identifier()));
+            else if (!childsEquals[1])
             {
-            case arrayItem:
-                if (!childsEquals[0])
-                    errorString = "В указанном месте идёт обращение к иному массиву. Должен быть массив " + QString::fromStdString(tree1->nodes[0]->id);
-                else if (!childsEquals[1])
-                    errorString = "В указанном месте идёт обращение к иной ячейке массива. Должно быть обращение к ячейке " + QString::number(tree1->nodes[1]->value);
-                break;
-            case mul:
-                if (!childsEquals[0])
-                    errorString = "Левый множитель неправильный. Должен быть" + QString::number(tree1->nodes[0]->value);
-                else if (!childsEquals[1])
-                    errorString = "Правый множитель неправильный. Должен быть" + QString::number(tree1->nodes[1]->value);
-                break;
-            case arrow:
-                if (!childsEquals[0])
-                    errorString = "В указанной операции идет обращение к иной пользовательской структуре данных. Имя необходимой структуры данных: " + QString::fromStdString(tree1->nodes[0]->id);
-                else if (!childsEquals[1])
-                {
-                    //найти сложный тип данных и определить тип
-                    int classPosition = 0;
-                    for (int i = 0; i < eni.customDataInfo.size(); i++)
-                        if (tree1->id == eni.customDataInfo[i]->id)
-                            classPosition = i;
-
-                    //пробить по базе данных имя поля (метода) и сказать, какое поле (метод) должно быть указано справа от точки
-                    bool isMethod = false;
-                    for (int i = 0; i < eni.customDataInfo[classPosition]->methods.size(); i++)
-                        if (eni.customDataInfo[classPosition]->methods[i]->id == tree1->id)
-                            isMethod = true;
-
-                    errorString = "У указанной операции " + QString::fromStdString(isMethod ? "вызывается иной метод. Необходим вызов метода:": "идет обращение к иному полю. Необходимое поле:")  + QString::fromStdString(tree1->nodes[1]->id);
-                }
-                break;
-            case dot:
-                if (!childsEquals[0])
-                    errorString = "В указанной операции идет обращение к иной пользовательской структуре данных. Имя необходимой структуры данных:" + QString::fromStdString(tree1->nodes[0]->id);
-                else if (!childsEquals[1])
-                {
-                    //найти сложный тип данных и определить тип
-                    int classPosition = 0;
-                    for (int i = 0; i < eni.customDataInfo.size(); i++)
-                        if (tree1->id == eni.customDataInfo[i]->id)
-                            classPosition = i;
+                //найти сложный тип данных и определить тип
+                CustomDataInfo* custom = staticTypes[tree2->nodes[0]].customData;
 
-                    //пробить по базе данных имя поля (метода) и сказать, какое поле (метод) должно быть указано справа от точки
-                    bool isMethod = false;
-                    for (int i = 0; i < eni.customDataInfo[classPosition]->methods.size(); i++)
-                        if (eni.customDataInfo[classPosition]->methods[i]->id == tree1->id)
-                            isMethod = true;
+                //пробить по базе данных имя поля (метода) и сказать, какое поле (метод) должно быть указано справа от стрелки
+                bool isMethod = custom != nullptr && custom->members.find(tree1->nodes[1]->identifier(), SYMBOL_FUNCTION) != nullptr;
 
-                    errorString = "" + QString::fromStdString(tree1->nodes[1]->id);
+                errorString = "У указанной операции " + QString::fromStdString(isMethod ? "вызывается иной метод. Необходим вызов метода:": "идет обращение к иному полю. Необходимое поле:")  + QString::fromStdString(eni.atoms.text(tree1->nodes[1]->identifier()));
+            }
+            break;
+        case dot:
+            if (!childsEquals[0])
+                errorString = "В указанной операции идет обращение к иной пользовательской структуре данных. Имя необходимой структуры данных:" + QString::fromStdString(eni.atoms.text(tree1->nodes[0]->identifier()));
+            else if (!childsEquals[1])
+            {
+                //найти сложный тип данных и определить тип
+                CustomDataInfo* custom = staticTypes[tree2->nodes[0]].customData;
 
-                }
+                //пробить по базе данных имя поля (метода) и сказать, какое поле (метод) должно быть указано справа от точки
+                bool isMethod = custom != nullptr && custom->members.find(tree1->nodes[1]->identifier(), SYMBOL_FUNCTION) != nullptr;
+
+                errorString = "У указанной операции " + QString::fromStdString(isMethod ? "вызывается иной метод. Необходим вызов метода:": "идет обращение к иному полю. Необходимое поле:")  + QString::fromStdString(eni.atoms.text(tree1->nodes[1]->identifier()));
+            }
+            break;
+        case dv:
+            if (!childsEquals[0])
+                errorString = "Делимое неправильное. Должно быть" + QString::number(tree1->nodes[0]->numericValue());
+            else if (!childsEquals[1])
+                errorString = "Делитель неправильный. Должен быть" + QString::number(tree1->nodes[1]->numericValue());
+            break;
+        case sub:
+            if (!childsEquals[0])
+                errorString = "Уменьшаемое неправильное. Должно быть" + QString::number(tree1->nodes[0]->numericValue());
+            else if (!childsEquals[1])
+                errorString = "Вычитаемое неправильное. Должно быть" + QString::number(tree1->nodes[1]->numericValue());
+            break;
+        case add:
+            if (!childsEquals[0])
+                errorString = "Левое слагаемое неправильное. Должно быть" + QString::number(tree1->nodes[0]->numericValue());
+            else if (!childsEquals[1])
+                errorString = "Правое слагаемое неправильное. Должно быть" + QString::number(tree1->nodes[1]->numericValue());
+            break;
+        case func:
+            if (!childsEquals[0])
+                errorString = "Указанная функция должна быть иной: " + QString::fromStdString(eni.atoms.text(tree1->nodes[0]->identifier()));
+        case pointer:
+            if (!childsEquals[0])
+                errorString = "Выражение под (*) не является указателем" + QString::fromStdString(eni.atoms.text(tree1->nodes[0]->identifier()));
+            break;
+        }
+        return false;
+    }
+    return true;
+}
+
+bool compareTextTreeAndExpressionTree(TreeNode* tree1, TreeNode* tree2, QString& errorString, ExpressionNeededInfo& eni, const StaticTypeTable& staticTypes, const TreeShapePool& shapes, const bool oneNode)
+{
+    return comparePairsPostOrder(tree1, tree2, false,
+        [&](TreeNode* node1, TreeNode* node2) { return compareTextAndExpressionNodes(node1, node2, shapes, errorString, oneNode); },
+        [&](TreeNode* node1, TreeNode* node2, const std::vector<bool>& childsEquals) { return explainOperatorDifference(node1, node2, childsEquals, errorString, eni, staticTypes); });
+}
+
+ResolvedType resolveType(const DataType& dataType, const SymbolTable& symbols)
+{
+    ResolvedType resolved = UNRESOLVED_TYPE;
+
+    //дойти до базового типа массива или указателя, считая уровни указателей и размерности массива
+    const DataType* base = &dataType;
+    while ((base->mainDataType == DT_ARRAY || base->mainDataType == DT_POINTER) && base->basicType != nullptr)
+    {
+        if (base->mainDataType == DT_POINTER)
+            resolved.pointerDepth++;
+        else
+        {
+            resolved.arrayDimensions += base->arraySize.size();
+            resolved.arrayType = base;
+        }
+        base = base->basicType;
+    }
+    resolved.baseType = base->mainDataType;
+
+    if (base->mainDataType == DT_CLASS || base->mainDataType == DT_STRUCT || base->mainDataType == DT_UNION)
+    {
+        const SymbolInfo* custom = symbols.find(base->id, SYMBOL_CUSTOM_DATA);
+        resolved.customData = custom != nullptr ? custom->customData : nullptr;
+    }
+    return resolved;
+}
+
+void buildMemberTables(const std::vector<CustomDataInfo*>& customDataInfo, const SymbolTable& symbols)
+{
+    for (int i = 0; i < customDataInfo.size(); i++)
+    {
+        CustomDataInfo* custom = customDataInfo[i];
+        custom->members.clear();
+        custom->methodSignatures.clear();
+        for (int k = 0; k < custom->fields.size(); k++)
+        {
+            VariableInfo* field = custom->fields[k];
+            field->resolvedType = resolveType(*field->dataType, symbols);
+            custom->members.insert(SymbolInfo{SYMBOL_VARIABLE, field->id, field->dataType, &field->resolvedType, nullptr, field, nullptr});
+        }
+        for (int k = 0; k < custom->methods.size(); k++)
+        {
+            FunctionInfo* method = custom->methods[k];
+            method->resolvedType = resolveType(*method->returnType, symbols);
+            custom->members.insert(SymbolInfo{SYMBOL_FUNCTION, method->id, method->returnType, &method->resolvedType, nullptr, nullptr, method});
+            custom->methodSignatures.insert(method);
+        }
+    }
+}
+
+void buildSymbolTable(ExpressionNeededInfo& eni)
+{
+    eni.symbols.clear();
+    eni.signatures.clear();
+
+    //сначала пользовательские типы данных, чтобы к ним можно было привязать переменные и функции
+    for (int i = 0; i < eni.includedCustomDataInfo.size(); i++)
+        eni.symbols.insert(SymbolInfo{SYMBOL_CUSTOM_DATA, eni.includedCustomDataInfo[i]->id, nullptr, nullptr, eni.includedCustomDataInfo[i], nullptr, nullptr});
+    for (int i = 0; i < eni.customDataInfo.size(); i++)
+        eni.symbols.insert(SymbolInfo{SYMBOL_CUSTOM_DATA, eni.customDataInfo[i]->id, nullptr, nullptr, eni.customDataInfo[i], nullptr, nullptr});
+
+    //разрешить типы полей и методов и построить таблицы членов (у типов библиотек они построены при загрузке)
+    buildMemberTables(eni.customDataInfo, eni.symbols);
+
+    for (int i = 0; i < eni.variablesInfo.size(); i++)
+    {
+        VariableInfo* variable = eni.variablesInfo[i];
+        variable->resolvedType = resolveType(*variable->dataType, eni.symbols);
+        eni.symbols.insert(SymbolInfo{SYMBOL_VARIABLE, variable->id, variable->dataType, &variable->resolvedType, nullptr, variable, nullptr});
+    }
+
+    for (int i = 0; i < eni.functionsInfo.size(); i++)
+    {
+        FunctionInfo* function = eni.functionsInfo[i];
+        function->resolvedType = resolveType(*function->returnType, eni.symbols);
+        eni.symbols.insert(SymbolInfo{SYMBOL_FUNCTION, function->id, function->returnType, &function->resolvedType, nullptr, nullptr, function});
+        eni.signatures.insert(function);
+    }
+}
+
+const SymbolInfo* findMember(const CustomDataInfo* custom, const TreeNode* member)
+{
+    //вызов метода ищется среди методов, обращение к полю - среди полей
+    return custom->members.find(member->identifier(), member->type == oper && member->op == func ? SYMBOL_FUNCTION : SYMBOL_VARIABLE);
+}
+
+void annotateStaticTypes(TreeNode* tree, const ExpressionNeededInfo& eni, StaticTypeTable& staticTypes)
+{
+    //типы дочерних вершин определяются раньше типа текущей
+    forEachPostOrder(tree, [&](TreeNode* node) { annotateNodeStaticType(node, eni, staticTypes); });
+}
+
+void annotateNodeStaticType(TreeNode* tree, const ExpressionNeededInfo& eni, StaticTypeTable& staticTypes)
+{
+    const StaticTypeTable& known = staticTypes; //уже определенные типы (таблица увеличивается только при записи)
+    ResolvedType type = UNRESOLVED_TYPE; //тип вершины
+
+    //доступ к члену: тип правого операнда определяется типом левого, а не таблицей символов
+    //(тип, определенный члену при его обходе, заменяется)
+    if (tree->type == oper && (tree->op == dot || tree->op == arrow) && tree->nodes.size() == 2)
+    {
+        TreeNode* member = tree->nodes[1];
+        const ResolvedType& object = known[tree->nodes[0]];
+        int pointerDepth = tree->op == arrow ? 1 : 0; //необходимое количество уровней указателей у левого операнда
+        const SymbolInfo* found = nullptr; //объявление члена
+        if (object.customData != nullptr && object.pointerDepth == pointerDepth && object.arrayDimensions == 0)
+            found = findMember(object.customData, member);
+        type = found != nullptr ? *found->type : UNRESOLVED_TYPE;
+        staticTypes[member] = type;
+        staticTypes[tree] = type;
+        return;
+    }
+
+    if (tree->type == constant_int)
+        type.baseType = DT_INT;
+    else if (tree->type == constant_float)
+        type.baseType = DT_FLOAT;
+    else if (tree->type == variable)
+    {
+        const SymbolInfo* variable = eni.symbols.find(tree->id, SYMBOL_VARIABLE);
+        if (variable != nullptr)
+            type = *variable->type;
+    }
+    else if (tree->op == func)
+    {
+        const SymbolInfo* function = eni.symbols.find(tree->id, SYMBOL_FUNCTION);
+        if (function != nullptr)
+            type = *function->type;
+    }
+    else if (tree->op == pointer || tree->op == arrayItem)
+    {
+        //разыменовать операнд, являющийся массивом или указателем (у A[B] им может быть любой из операндов)
+        for (int i = 0; i < tree->nodes.size() && type.baseType == DT_NONE; i++)
+        {
+            const ResolvedType& operand = known[tree->nodes[i]];
+            if (operand.arrayDimensions > 0 || operand.pointerDepth > 0)
+            {
+                type = operand;
+                if (operand.arrayDimensions > 0)
+                    type.arrayDimensions--;
+                else
+                    type.pointerDepth--;
+            }
+        }
+    }
+    else if (tree->op == add || tree->op == sub || tree->op == mul || tree->op == dv)
+    {
+        bool allKnown = true; //типы всех операндов определены и являются числовыми
+        bool isFloat = false; //среди операндов есть дробный
+        bool isAddress = false; //адресная арифметика сохраняет тип указателя
+        for (int i = 0; i < tree->nodes.size() && !isAddress; i++)
+        {
+            const ResolvedType& operand = known[tree->nodes[i]];
+            if (operand.arrayDimensions > 0 || operand.pointerDepth > 0)
+            {
+                type = operand;
+                isAddress = true;
+            }
+            else if (operand.baseType == DT_FLOAT)
+                isFloat = true;
+            else if (operand.baseType != DT_INT)
+                allKnown = false;
+        }
+        if (allKnown && !isAddress)
+            type.baseType = isFloat ? DT_FLOAT : DT_INT;
+    }
+    staticTypes[tree] = type;
+}
+
+void foldIntegerConstant(TreeNode* tree, const StaticTypeTable& staticTypes)
+{
+    tree->isFoldedConstant = false;
+
+    if (tree->type == constant_int)
+        tree->isFoldedConstant = true; //значение константы уже хранится в intValue
+    else if (tree->type == oper && staticTypes[tree].isInteger() && !tree->nodes.empty() &&
+             (tree->op == add || tree->op == sub || tree->op == mul || tree->op == dv))
+    {
+        bool allFolded = tree->nodes[0]->isFoldedConstant; //вычислены ли все операнды
+        long long result = tree->nodes[0]->intValue; //значение выражения
+        for (int i = 1; i < tree->nodes.size() && allFolded; i++)
+        {
+            long long operand = tree->nodes[i]->intValue;
+            allFolded = tree->nodes[i]->isFoldedConstant && !(tree->op == dv && operand == 0);
+            if (!allFolded)
                 break;
+            //при переполнении long long вершина остается невычисленной
+            switch (tree->op)
+            {
+            case add: allFolded = !__builtin_add_overflow(result, operand, &result); break;
+            case sub: allFolded = !__builtin_sub_overflow(result, operand, &result); break;
+            case mul: allFolded = !__builtin_mul_overflow(result, operand, &result); break;
             case dv:
-                if (!childsEquals[0])
-                    errorString = "Делимое неправильное. Должно быть" + QString::number(tree1->nodes[0]->value);
-                else if (!childsEquals[1])
-                    errorString = "Делитель неправильный. Должен быть" + QString::number(tree1->nodes[1]->value);
-                break;
-            case sub:
-                if (!childsEquals[0])
-                    errorString = "Уменьшаемое неправильное. Должно быть" + QString::number(tree1->nodes[0]->value);
-                else if (!childsEquals[1])
-                    errorString = "Вычитаемое неправильное. Должно быть" + QString::number(tree1->nodes[1]->value);
-                break;
-            case add:
-                if (!childsEquals[0])
-                    errorString = "Левое слагаемое неправильное. Должно быть" + QString::number(tree1->nodes[0]->value);
-                else if (!childsEquals[1])
-                    errorString = "Правое слагаемое неправильное. Должно быть" + QString::number(tree1->nodes[1]->value);
-                break;
-            case func:
-                if (!childsEquals[0])
-                    errorString = "Указанная функция должна быть иной: " + QString::fromStdString(tree1->nodes[0]->id);
-            case pointer:
-                if (!childsEquals[0])
-                    errorString = "Выражение под (*) не является указателем" + QString::fromStdString(tree1->nodes[0]->id);
+                allFolded = !(result == LLONG_MIN && operand == -1);
+                if (allFolded)
+                    result /= operand;
                 break;
+            default: allFolded = false; break;
             }
-            return false;
         }
+        tree->isFoldedConstant = allFolded;
+        tree->intValue = result;
     }
-    return true;
 }
 
-void bringTreeToStandartForm(TreeNode* tree, ExpressionNeededInfo& expressionNeededInfo, std::string& polsk, std::vector<ErrorInfo>& errorList)
+Atom findArrayName(TreeNode* arrayNode)
+{
+    //дойти до массива, с которого начинается цепочка обращений к элементам
+    while (arrayNode->type == oper && arrayNode->op == arrayItem)
+        arrayNode = arrayNode->nodes[0];
+    return arrayNode->identifier();
+}
+
+Atom findRootName(TreeNode* operand)
+{
+    //дойти по левым операндам до переменной или вызова функции
+    while (operand->type == oper && operand->op != func && !operand->nodes.empty())
+        operand = operand->nodes[0];
+    return operand->identifier();
+}
+
+void bringTreeToStandartForm(TreeNode* tree, ExpressionNeededInfo& expressionNeededInfo, const StaticTypeTable& staticTypes, std::string_view polsk, std::vector<ErrorInfo>& errorList)
+{
+    //дочерние вершины приводятся раньше текущей
+    forEachPostOrder(tree, [&](TreeNode* node) { bringNodeToStandartForm(node, expressionNeededInfo, staticTypes, polsk, errorList); });
+}
+
+void bringNodeToStandartForm(TreeNode* tree, ExpressionNeededInfo& expressionNeededInfo, const StaticTypeTable& staticTypes, std::string_view polsk, std::vector<ErrorInfo>& errorList)
 {
 
-    //рекурсивные вызовы для дочерних вершин
-    for (int i = 0; i < tree->nodes.size(); i++)
-        bringTreeToStandartForm(tree->nodes[i], expressionNeededInfo, polsk, errorList);
+    //вычислить значение целочисленного выражения, если все его операнды уже вычислены
+    foldIntegerConstant(tree, staticTypes);
 
     if(tree->type == oper){
     //эквивалентность A[B]
@@ -1136,46 +1748,37 @@ void bringTreeToStandartForm(TreeNode* tree, ExpressionNeededInfo& expressionNee
         bool zeroIsArray = false; //нулевой из операндов является ARRAY
         bool oneIsInt = false; //первый из операндов является INT
         bool oneIsArray = false; //первый из операндов является ARRAY
-        int arraySize = 0; //размерность массива
-        int index = 0; //номер адресуемой ячейки в массиве
+        int arraySize = 0; //размер индексируемой размерности массива
+        TreeNode* indexNode = nullptr; //операнд-индекс
+        TreeNode* arrayNode = nullptr; //операнд-массив
         for (int i = 0; i < 2; i++) {
-            for (int j = 0; j < expressionNeededInfo.functionsInfo.size(); j++) {
-                if (tree->nodes[i]->id == expressionNeededInfo.functionsInfo[j]->id &&
-                    expressionNeededInfo.functionsInfo[j]->returnType.mainDataType == DT_INT)
-                {
-                    (i == 0 ? zeroIsInt : oneIsInt) = true;
-                    index = tree->nodes[i]->value;
-                }
-            }for (int j = 0; j < expressionNeededInfo.variablesInfo.size(); j++) {
-                //проверка на целое число
-                if ((tree->nodes[i]->id == expressionNeededInfo.variablesInfo[j]->id && //1) переменная типа DT_INT
-                    expressionNeededInfo.variablesInfo[j]->dataType.mainDataType == DT_INT) ||
-                    tree->nodes[i]->type == constant_int ||
-                        (tree->nodes[i]->type == oper && (tree->nodes[i]->op == add  || tree->nodes[i]->op == sub || tree->nodes[i]->op == mul || tree->nodes[i]->op == dv))) //2) константа с целым значением
-                {
-                    (i == 0 ? zeroIsInt : oneIsInt) = true;
-                    index = tree->nodes[i]->value;
-                }
-                //проверка на тип DT_ARRAY
-                if (tree->nodes[i]->id == expressionNeededInfo.variablesInfo[j]->id && //переменная типа DT_ARRAY
-                    expressionNeededInfo.variablesInfo[j]->dataType.mainDataType == DT_ARRAY)
-                {
-                    (i == 0 ? zeroIsArray : oneIsArray) = true;
-                    arraySize = expressionNeededInfo.variablesInfo[j]->dataType.arraySize[0];
-                }
+            const ResolvedType& operandType = staticTypes[tree->nodes[i]];
+            //проверка на целое число
+            if (operandType.isInteger())
+            {
+                (i == 0 ? zeroIsInt : oneIsInt) = true;
+                indexNode = tree->nodes[i];
+            }
+            //проверка на тип DT_ARRAY
+            if (operandType.arrayDimensions > 0)
+            {
+                (i == 0 ? zeroIsArray : oneIsArray) = true;
+                arrayNode = tree->nodes[i];
+                arraySize = operandType.currentArraySize();
             }
         }
 
         if (!zeroIsInt && !oneIsInt) //интов не нашлось
-            errorList.push_back(ErrorInfo(ERROR_EXP_INT, {QString::fromStdString(polsk), QString::number(tree->pos), QString::fromStdString(tree->nodes[0]->id), QString::fromStdString(tree->nodes[1]->id)}));
+            errorList.push_back(ErrorInfo(ERROR_EXP_INT, {toQString(polsk), QString::number(tree->pos), QString::fromStdString(expressionNeededInfo.atoms.text(tree->nodes[0]->identifier())), QString::fromStdString(expressionNeededInfo.atoms.text(tree->nodes[1]->identifier()))}));
         else if (!zeroIsArray && !oneIsArray) //массивов не нашлось
-            errorList.push_back(ErrorInfo(ERROR_EXP_ARRAY, {QString::fromStdString(polsk), QString::number(tree->pos), QString::fromStdString(tree->nodes[0]->id), QString::fromStdString(tree->nodes[1]->id)}));
-        else if (zeroIsInt) //или oneIsArray
+            errorList.push_back(ErrorInfo(ERROR_EXP_ARRAY, {toQString(polsk), QString::number(tree->pos), QString::fromStdString(expressionNeededInfo.atoms.text(tree->nodes[0]->identifier())), QString::fromStdString(expressionNeededInfo.atoms.text(tree->nodes[1]->identifier()))}));
+        else
         {
-            //проверить границы массива
-            if (index < 0 || index > arraySize - 1)
-                errorList.push_back(ErrorInfo(ERROR_OUT_OF_RANGE_ARRAY, {QString::number(index), QString::fromStdString(tree->nodes[0]->id)}));
-            else std::swap(tree->nodes[0], tree->nodes[1]); //преобразовать
+            //проверить границы размерности массива, если индекс удалось вычислить
+            if (indexNode->isFoldedConstant && (indexNode->intValue < 0 || indexNode->intValue > arraySize - 1))
+                errorList.push_back(ErrorInfo(ERROR_OUT_OF_RANGE_ARRAY, {QString::number(indexNode->intValue), QString::fromStdString(expressionNeededInfo.atoms.text(findArrayName(arrayNode)))}));
+            else if (zeroIsInt) //или oneIsArray
+                std::swap(tree->nodes[0], tree->nodes[1]); //преобразовать
         }
     }
 
@@ -1187,48 +1790,39 @@ void bringTreeToStandartForm(TreeNode* tree, ExpressionNeededInfo& expressionNee
         bool zeroIsArray = false; //нулевой из операндов является ARRAY
         bool oneIsInt = false;       //первый из операндов является INT
         bool oneIsArray = false; //первый из операндов является ARRAY
-        int arraySize = 0;            //размерность массива
-        int index = 0;                 //номер адресуемой ячейки в массиве
+        int arraySize = 0;            //размер индексируемой размерности массива
+        TreeNode* indexNode = nullptr; //слагаемое-индекс
+        TreeNode* arrayNode = nullptr; //слагаемое-массив
         //проверить типы слагаемых
         for (int i = 0; i < 2; i++) {
-            for (int j = 0; j < expressionNeededInfo.functionsInfo.size(); j++) {
-                if (tree->nodes[0]->nodes[i]->id == expressionNeededInfo.functionsInfo[j]->id &&
-                    expressionNeededInfo.functionsInfo[j]->returnType.mainDataType == DT_INT)
-                {
-                    (i == 0 ? zeroIsInt : oneIsInt) = true;
-                    index = tree->nodes[0]->nodes[i]->value;
-                }
-            }for (int j = 0; j < expressionNeededInfo.variablesInfo.size(); j++) {
-                //проверка на целое число
-                if ((tree->nodes[0]->nodes[i]->id == expressionNeededInfo.variablesInfo[j]->id && //1) переменная типа DT_INT
-                    expressionNeededInfo.variablesInfo[j]->dataType.mainDataType == DT_INT) ||
-                    tree->nodes[0]->nodes[i]->type == constant_int) { //2) константа с целым значением
-
-                    (i == 0 ? zeroIsInt : oneIsInt) = true;
-                    index = tree->nodes[0]->nodes[i]->value;
-                }
-                //проверка на тип DT_ARRAY
-                if (tree->nodes[0]->nodes[i]->id == expressionNeededInfo.variablesInfo[j]->id && //переменная типа DT_ARRAY
-                    expressionNeededInfo.variablesInfo[j]->dataType.mainDataType == DT_ARRAY)
-                {
-                    (i == 0 ? zeroIsArray : oneIsArray) = true;
-                    arraySize = expressionNeededInfo.variablesInfo[j]->dataType.arraySize[0];
-                }
+            const ResolvedType& operandType = staticTypes[tree->nodes[0]->nodes[i]];
+            //проверка на целое число
+            if (operandType.isInteger()) {
+                (i == 0 ? zeroIsInt : oneIsInt) = true;
+                indexNode = tree->nodes[0]->nodes[i];
+            }
+            //проверка на тип DT_ARRAY
+            if (operandType.arrayDimensions > 0)
+            {
+                (i == 0 ? zeroIsArray : oneIsArray) = true;
+                arrayNode = tree->nodes[0]->nodes[i];
+                arraySize = operandType.currentArraySize();
             }
         }
 
         if (!zeroIsInt && !oneIsInt) //интов не нашлось
-            errorList.push_back(ErrorInfo(ERROR_EXP_INT, {QString::fromStdString(polsk), QString::number(tree->pos), QString::fromStdString(tree->nodes[0]->nodes[0]->id), QString::fromStdString(tree->nodes[0]->nodes[1]->id)}));
+            errorList.push_back(ErrorInfo(ERROR_EXP_INT, {toQString(polsk), QString::number(tree->pos), QString::fromStdString(expressionNeededInfo.atoms.text(tree->nodes[0]->nodes[0]->identifier())), QString::fromStdString(expressionNeededInfo.atoms.text(tree->nodes[0]->nodes[1]->identifier()))}));
         else if (!zeroIsArray && !oneIsArray) //массивов не нашлось
-             errorList.push_back(ErrorInfo(ERROR_EXP_ARRAY, {QString::fromStdString(polsk), QString::number(tree->pos), QString::fromStdString(tree->nodes[0]->nodes[0]->id), QString::fromStdString(tree->nodes[0]->nodes[1]->id)}));
+             errorList.push_back(ErrorInfo(ERROR_EXP_ARRAY, {toQString(polsk), QString::number(tree->pos), QString::fromStdString(expressionNeededInfo.atoms.text(tree->nodes[0]->nodes[0]->identifier())), QString::fromStdString(expressionNeededInfo.atoms.text(tree->nodes[0]->nodes[1]->identifier()))}));
         else {
-            if (index < 0 || index > arraySize - 1) //проверить границы массива
-                errorList.push_back(ErrorInfo(ERROR_OUT_OF_RANGE_ARRAY, {QString::number(index), QString::fromStdString(tree->nodes[0]->nodes[0]->id)}));
+            long long index = tree->nodes[0]->op == sub ? -indexNode->intValue : indexNode->intValue; //номер адресуемой ячейки в массиве
+            if (indexNode->isFoldedConstant && (index < 0 || index > arraySize - 1)) //проверить границы размерности массива, если индекс удалось вычислить
+                errorList.push_back(ErrorInfo(ERROR_OUT_OF_RANGE_ARRAY, {QString::number(index), QString::fromStdString(expressionNeededInfo.atoms.text(findArrayName(arrayNode)))}));
             else
             {
                 //преобразовать
                 tree->op = arrayItem;
-                tree->nodes = tree->nodes[0]->nodes;
+                tree->nodes = std::move(tree->nodes[0]->nodes);
                 if (zeroIsInt)
                     std::swap(tree->nodes[0], tree->nodes[1]);
             }
@@ -1240,153 +1834,50 @@ void bringTreeToStandartForm(TreeNode* tree, ExpressionNeededInfo& expressionNee
     {
 
         tree->op = arrow;
-        tree->nodes = tree->nodes[0]->nodes;
+        tree->nodes = std::move(tree->nodes[0]->nodes);
     }
 
-    //проверка типов в A.B
-    if (tree->op == dot)
+    //проверка типов в A.B и A->B
+    if (tree->op == dot || tree->op == arrow)
     {
 
-        bool AisVariable = false;
-        bool BisField = false;
-        bool BisMethod = false;
-        int classPosition;
         std::string customType;
-        TreeNode* buff = tree->nodes[0];
-
-        //проверка A - класс, а B - поле этого класса       
-        while (buff->type == oper){
-            buff = buff->nodes[0];
-        }
-
-        //найти название класса
-        for (int i = 0; i < expressionNeededInfo.variablesInfo.size(); i++)
-            if (buff->id == expressionNeededInfo.variablesInfo[i]->id)
-            {
-                AisVariable = true;
-
-                bool classFound = false;
-                for (int j = 0; j < expressionNeededInfo.customDataInfo.size(); j++)
-                    if (expressionNeededInfo.variablesInfo[i]->dataType.id == expressionNeededInfo.customDataInfo[j]->id)
-                    {
-                        classFound = true;
-                        classPosition = j;
-                    } else if(expressionNeededInfo.variablesInfo[i]->dataType.basicType->id == expressionNeededInfo.customDataInfo[j]->id){
-                        classFound = true;
-                        classPosition = j;
-                    } else if(expressionNeededInfo.variablesInfo[i]->dataType.basicType->basicType->id == expressionNeededInfo.customDataInfo[j]->id){
-                        classFound = true;
-                        classPosition = j;
-                    }
+        const ResolvedType& object = staticTypes[tree->nodes[0]]; //тип A
+        int pointerDepth = tree->op == arrow ? 1 : 0; //необходимое количество уровней указателей у A
 
-                if (!classFound)
-                    errorList.push_back(ErrorInfo(ERROR_NO_CUSTOM_IN_DB, {QString::fromStdString(expressionNeededInfo.variablesInfo[i]->id)}));
+        //проверка A - класс (указатель на класс), а B - поле этого класса
+        bool isCustom = object.pointerDepth == pointerDepth && object.arrayDimensions == 0 &&
+                        (object.baseType == DT_CLASS || object.baseType == DT_STRUCT || object.baseType == DT_UNION);
+        CustomDataInfo* custom = isCustom ? object.customData : nullptr;
+        if (isCustom && custom == nullptr) //пользовательский тип данных не объявлен
+            errorList.push_back(ErrorInfo(tree->op == dot ? ERROR_NO_CUSTOM_IN_DB : ERROR_ANALYZE_EXP_NO_VAR_IN_DB, {QString::fromStdString(expressionNeededInfo.atoms.text(findRootName(tree->nodes[0])))}));
 
-                switch (expressionNeededInfo.customDataInfo[i]->type)
-                {
-                case DT_CLASS:
-                    customType = "класса";
-                    break;
-                case DT_UNION:
-                    customType = "объединения";
-                    break;
-                case DT_STRUCT:
-                    customType = "структуры";
-                    break;
-                }
-            }
-
-        if (AisVariable)
+        if (custom != nullptr)
         {
-            //найти поле B в этом классе
-            for (int i = 0; i < expressionNeededInfo.customDataInfo[classPosition]->fields.size(); i++)
-                if (tree->nodes[1]->id == expressionNeededInfo.customDataInfo[classPosition]->fields[i]->id)
-                    BisField = true;
-
-            //найти метод B в этом классе
-            for (int i = 0; i < expressionNeededInfo.customDataInfo[classPosition]->methods.size(); i++)
-                if (tree->nodes[1]->id == expressionNeededInfo.customDataInfo[classPosition]->methods[i]->id)
-                    BisMethod = true;
-
-            if (!BisMethod && !BisField)
-                errorList.push_back(ErrorInfo(ERROR_EXP_CUSTOM, {QString::fromStdString(tree->nodes[1]->id), QString::fromStdString(customType), QString::fromStdString(polsk),  QString::number(tree->pos)}));
-
-        }
-        else
-            errorList.push_back(ErrorInfo(ERROR_EXP_FIELD, {QString::fromStdString(tree->nodes[0]->id), QString::fromStdString(polsk), QString::number(tree->pos)}));
-    }
-
-    //проверка типов в A->B
-    if (tree->op == arrow)
-    {
-
-        bool AisVariable = false;
-        bool BisField = false;
-        bool BisMethod = false;
-        int classPosition;
-        std::string customType;
-        TreeNode* buff = tree->nodes[0];
-
-        //проверка A - указатель на класс, а B - поле этого класса
-        while (buff->type == oper){
-            buff = buff->nodes[0];
-        }
-        //найти название класса
-        for (int i = 0; i < expressionNeededInfo.variablesInfo.size(); i++)
-            if ((DT_POINTER == expressionNeededInfo.variablesInfo[i]->dataType.mainDataType || DT_POINTER == expressionNeededInfo.variablesInfo[i]->dataType.basicType->mainDataType) &&
-                buff->id == expressionNeededInfo.variablesInfo[i]->id)
+            switch (custom->type)
             {
-                AisVariable = true;
-
-                bool classFound = false;
-                for (int j = 0; j < expressionNeededInfo.customDataInfo.size(); j++)
-                    if (expressionNeededInfo.variablesInfo[i]->dataType.id == expressionNeededInfo.customDataInfo[j]->id)
-                    {
-                        classFound = true;
-                        classPosition = j;
-                    } else if(expressionNeededInfo.variablesInfo[i]->dataType.basicType->id == expressionNeededInfo.customDataInfo[j]->id){
-                        classFound = true;
-                        classPosition = j;
-                    } else if(expressionNeededInfo.variablesInfo[i]->dataType.basicType->basicType->id == expressionNeededInfo.customDataInfo[j]->id){
-                        classFound = true;
-                        classPosition = j;
-                    }
-
-
-                if (!classFound)
-                    errorList.push_back({ ERROR_ANALYZE_EXP_NO_VAR_IN_DB, { QString::fromStdString(expressionNeededInfo.variablesInfo[i]->id) } });
-
-                switch (expressionNeededInfo.customDataInfo[classPosition]->type)
-                {
-                case DT_CLASS:
-                    customType = "класса";
-                    break;
-                case DT_UNION:
-                    customType = "объединения";
-                    break;
-                case DT_STRUCT:
-                    customType = "структуры";
-                    break;
-                }
+            case DT_CLASS:
+                customType = "класса";
+                break;
+            case DT_UNION:
+                customType = "объединения";
+                break;
+            case DT_STRUCT:
+                customType = "структуры";
+                break;
             }
 
-        if (AisVariable)
-        {
-            //найти поле B в этом классе
-            for (int i = 0; i < expressionNeededInfo.customDataInfo[classPosition]->fields.size(); i++)
-                if (tree->nodes[1]->id == expressionNeededInfo.customDataInfo[classPosition]->fields[i]->id)
-                    BisField = true;
-
-            //найти метод B в этом классе
-            for (int i = 0; i < expressionNeededInfo.customDataInfo[classPosition]->methods.size(); i++)
-                if (tree->nodes[1]->id == expressionNeededInfo.customDataInfo[classPosition]->methods[i]->id)
-                    BisMethod = true;
-
-            if (!BisMethod && !BisField)
-                errorList.push_back(ErrorInfo(ERROR_EXP_CUSTOM, {QString::fromStdString(tree->nodes[1]->id), QString::fromStdString(customType), QString::fromStdString(polsk),  QString::number(tree->pos)}));
+            //найти поле или метод B в этом классе
+            TreeNode* member = tree->nodes[1];
+            const SymbolInfo* found = findMember(custom, member);
+            if (found == nullptr)
+                errorList.push_back(ErrorInfo(ERROR_EXP_CUSTOM, {QString::fromStdString(expressionNeededInfo.atoms.text(member->identifier())), QString::fromStdString(customType), toQString(polsk),  QString::number(tree->pos)}));
+            //у вызова метода проверить количество аргументов по сигнатурам методов
+            else if (found->kind == SYMBOL_FUNCTION && custom->methodSignatures.find(member->identifier(), member->nodes.size()) == nullptr)
+                errorList.push_back(ErrorInfo(ERROR_ANALYZE_EXP_FUNC_ARITY, {QString::fromStdString(expressionNeededInfo.atoms.text(member->identifier())), QString::number(member->nodes.size()), QString::number(found->function->arity)}));
         }
-        else
-             errorList.push_back(ErrorInfo(ERROR_EXP_POINT_FIELD, {QString::fromStdString(tree->nodes[0]->id), QString::fromStdString(polsk), QString::number(tree->pos)}));
+        else if (!isCustom)
+            errorList.push_back(ErrorInfo(tree->op == dot ? ERROR_EXP_FIELD : ERROR_EXP_POINT_FIELD, {QString::fromStdString(expressionNeededInfo.atoms.text(tree->nodes[0]->identifier())), toQString(polsk), QString::number(tree->pos)}));
     }
 
     //проверка типов переменных у арифметических операторов
@@ -1397,15 +1888,12 @@ void bringTreeToStandartForm(TreeNode* tree, ExpressionNeededInfo& expressionNee
         {
             if (tree->nodes[i]->type == variable)
             {
-                bool ok = false;
-                for (int i = 0; i < expressionNeededInfo.variablesInfo.size(); i++)
-                    if (tree->nodes[0]->id == expressionNeededInfo.variablesInfo[i]->id ||
-                        tree->nodes[1]->id == expressionNeededInfo.variablesInfo[i]->id)
-                        ok = true;
+                bool ok = expressionNeededInfo.symbols.find(tree->nodes[0]->identifier(), SYMBOL_VARIABLE) != nullptr ||
+                          expressionNeededInfo.symbols.find(tree->nodes[1]->identifier(), SYMBOL_VARIABLE) != nullptr;
 
                 if (!ok)
                 {
-                    errorList.push_back({ ERROR_ANALYZE_EXP_NO_VAR_IN_DB, { QString::fromStdString(tree->nodes[0]->id) } });
+                    errorList.push_back({ ERROR_ANALYZE_EXP_NO_VAR_IN_DB, { QString::fromStdString(expressionNeededInfo.atoms.text(tree->nodes[0]->identifier())) } });
                 }
             }
         }
@@ -1415,89 +1903,320 @@ void bringTreeToStandartForm(TreeNode* tree, ExpressionNeededInfo& expressionNee
     if (tree->op == pointer)
     {
 
-        bool varFound = false;
-        for (int i = 0; i < expressionNeededInfo.variablesInfo.size(); i++)
-            if (tree->nodes[0]->id == expressionNeededInfo.variablesInfo[i]->id)
-                varFound = true;
+        bool varFound = expressionNeededInfo.symbols.find(tree->nodes[0]->identifier(), SYMBOL_VARIABLE) != nullptr;
 
         if (!varFound)
-            errorList.push_back({ ERROR_ANALYZE_EXP_NO_VAR_IN_DB, { QString::fromStdString(tree->nodes[0]->id) } });
+            errorList.push_back({ ERROR_ANALYZE_EXP_NO_VAR_IN_DB, { QString::fromStdString(expressionNeededInfo.atoms.text(tree->nodes[0]->identifier())) } });
     }
 }
 }
 
-void convertTreeToString(TreeNode* tree, std::string& strout)
-{
-    std::string str; //строковое представление текущей вершины
+/*!
+ * \brief Проход построения строкового представления дерева
+ *
+ * Представления дочерних вершин дописываются прямо в выходную строку, без промежуточных строк на каждую вершину.
+ * Оператор не записывается сразу, а раскладывается на очередь из дочерних вершин и готовых фрагментов текста,
+ * поэтому глубина дерева не ограничена стеком вызовов. Позиция вершины с ошибкой пользователя запоминается
+ * во время записи, поэтому строку не нужно повторно просматривать в поисках метки
+ */
+class TreeStringWriter : public TreeVisitor<TreeStringWriter> {
+public:
+    TreeStringWriter(const StringInterner& atoms, std::string& strout) : atoms(atoms), strout(strout), markPos(std::string::npos) {}
+
+    /*!
+     * \brief Записать дерево в выходную строку
+     * \param [in] tree - корень дерева
+     */
+    void write(TreeNode* tree)
+    {
+        items.push_back({tree, nullptr});
+        while (!items.empty())
+        {
+            Item item = items.back();
+            items.pop_back();
+            if (item.node != nullptr)
+                visit(item.node);
+            else if (item.text != nullptr)
+                strout.append(item.text);
+            else
+                mark();
+        }
+    }
 
-    if (tree->type == constant_int || tree->type == constant_float) //если данная вершина является константой
+    /*!
+     * \brief Получить позицию в выходной строке первой вершины с ошибкой пользователя
+     * \return Позиция или std::string::npos, если таких вершин нет
+     */
+    size_t markPosition() const
     {
-        char buffer[25] = { 0 }; //буфер для перевода константы
-        str.append(tree->id);
-        str.append(QString::number(tree->value).toStdString()); //строка с константой
+        return markPos;
     }
-    else if (tree->type == variable) //если данна вершина является переменной
+
+    void visitConstant(TreeNode* tree)
     {
-        str = tree->id;
+        if (tree->marked)
+            mark();
+        //строка с константой
+        if (tree->type == constant_int)
+            strout.append(std::to_string(tree->intValue));
+        else
+            strout.append(QString::number(tree->value).toStdString());
     }
-    else //данная вершина является оператором
+
+    void visitVariable(TreeNode* tree)
     {
-        std::vector<std::string> args; //список строковых представлений дочерних вершин
+        if (tree->marked)
+            mark();
+        strout.append(atoms.text(tree->id));
+    }
 
-        //для каждой дочерней вершины
-        for (int i = 0; i < tree->nodes.size(); i++)
-        {
-            //определить строковое представление дочерней вершины
-            std::string cur;
-            convertTreeToString(tree->nodes[i], cur);
-            args.push_back(cur);
-        }
+    void visitOperator(TreeNode* tree)
+    {
+        size_t first = items.size(); //фрагменты текущей вершины добавляются в порядке записи и затем переворачиваются
 
-        //слепить в строковое представление текущей вершины...
         //определить особый оператор в текущей вершине
         if (tree->op == pointer) { //в данной вершине указатель
-            str.append(tree->id);
-            str.append("*(");
-            str.append(args[0]); //операция унарная
-            str.append(")");
+            markItem(tree);
+            text("*(");
+            node(tree->nodes[0]); //операция унарная
+            text(")");
         }
         else if (tree->op == arrayItem) { //в данной вершине операция []
-            str.append(args[0]); //операция бинарная
-            str.append(tree->id);
-            str.append("[");
-            str.append(args[1]);
-            str.append("]");
+            node(tree->nodes[0]); //операция бинарная
+            markItem(tree);
+            text("[");
+            node(tree->nodes[1]);
+            text("]");
         }
         else if (tree->op == func) { //в данной вершине операция вызова функции
-            str.append(tree->id);
-            str.append("(");
-            if (args.size() > 0) //аргументы есть?
+            markItem(tree);
+            text(atoms.text(tree->id).c_str());
+            text("(");
+            for (int i = 0; i < tree->nodes.size(); i++)
             {
-                str.append(args[0]);
-                for (int i = 1; i < args.size(); i++)
-                {
-                    str.append(", ");
-                    str.append(args[i]);
-                }
+                if (i > 0)
+                    text(", ");
+                node(tree->nodes[i]);
             }
-            str.append(")");
+            text(")");
         }
         else //иначе стандартный оператор (+ - * / ...)
         {
-            str.append(args[0]); //стандартный оператор имеет минимум 2 операнда
-            for (int i = 1; i < args.size(); i++)
+            node(tree->nodes[0]); //стандартный оператор имеет минимум 2 операнда
+            for (int i = 1; i < tree->nodes.size(); i++)
             {
-                str.append(tree->id);
-                str.append(tree->operatorString());
-                str.append(args[i]);
+                markItem(tree);
+                text(tree->operatorString());
+                node(tree->nodes[i]);
             }
         }
+
+        std::reverse(items.begin() + first, items.end());
+    }
+
+private:
+    /*!
+     * \brief Элемент очереди записи: вершина или готовый фрагмент текста
+     */
+    struct Item {
+        TreeNode* node;         ///< записываемая вершина (nullptr у фрагмента текста)
+        const char* text;        ///< фрагмент текста (nullptr у метки ошибки пользователя)
+    };
+
+    /*!
+     * \brief Запомнить текущую позицию выходной строки как позицию ошибки пользователя, если она еще не найдена
+     */
+    void mark()
+    {
+        if (markPos == std::string::npos)
+            markPos = strout.size();
     }
 
-    strout.append(str);
+    /*!
+     * \brief Добавить в очередь записи метку ошибки пользователя, если вершина отмечена
+     */
+    void markItem(const TreeNode* tree)
+    {
+        if (tree->marked)
+            items.push_back({nullptr, nullptr});
+    }
+
+    /*!
+     * \brief Добавить в очередь записи вершину
+     */
+    void node(TreeNode* tree)
+    {
+        items.push_back({tree, nullptr});
+    }
+
+    /*!
+     * \brief Добавить в очередь записи фрагмент текста
+     */
+    void text(const char* str)
+    {
+        items.push_back({nullptr, str});
+    }
+
+    const StringInterner& atoms;    ///< атомы идентификаторов контекста
+    std::string& strout;                ///< выходная строка
+    std::vector<Item> items;           ///< очередь записи (следующий элемент - последний)
+    size_t markPos;                     ///< позиция первой вершины с ошибкой пользователя
+};
+
+void convertTreeToString(TreeNode* tree, const StringInterner& atoms, std::string& strout, int& caret)
+{
+    TreeStringWriter writer(atoms, strout);
+    writer.write(tree);
+    //указатель ставится на символ перед отмеченной вершиной
+    size_t pos = writer.markPosition();
+    caret = pos != std::string::npos && pos > 0 ? (int)pos - 1 : 0;
+}
+
+const TreeShape* internTree(TreeNode* tree, TreeShapePool& shapes)
+{
+    TreeShape shape; //структура текущего поддерева
+    //структуры дочерних поддеревьев добавляются в DAG раньше структуры текущего
+    forEachPostOrder(tree, [&](TreeNode* node) {
+        shape.type = node->type;
+        shape.op = node->type == oper ? node->op : arrayItem;
+        shape.id = node->identifier();
+        shape.value = node->constantBits();
+        shape.children.clear();
+        for (int i = 0; i < node->nodes.size(); i++)
+            shape.children.push_back(shapes.shapeOf(node->nodes[i]));
+        shapes.intern(node, shape);
+    });
+    return shapes.shapeOf(tree);
 }
 
-void writeMessage(std::string nameOutFile, QString errorMessage, std::vector <ErrorInfo>& errorsInfo, std::string strout, QString exepath){
+bool runJob(const std::string& pathExp, const std::string& pathXml, TreeArena& trees, TreeShapePool& shapes, StaticTypeTable& staticTypes, QString& errorMessage, std::string& strout, int& caret, std::vector<ErrorInfo>& errorsInfo){
+    // Считывание вспомогательной информации для вычисления выражения...
+    ExpressionNeededInfo exprNeedInfo;
+    std::vector<CustomDataInfo*> customDataInfo;
+    std::vector<FunctionInfo*> functionsInfo;
+    std::vector<VariableInfo*> variablesInfo;
+
+    if(errorsInfo.empty()){
+
+        tinyxml2::XMLDocument xmlDoc; //Документ для запси xml дерева
+        DeclaredNames declared; //Имена прочитанных объявлений для поиска повторных объявлений
+
+        bool isNotEmpty = readXMLTreeFromFile(pathXml,  xmlDoc,  errorsInfo); //Считать xml дерево
+
+        if(errorsInfo.empty() && isNotEmpty ){
+            exprNeedInfo.includedCustomDataInfo = readIncludesFromXML(xmlDoc, pathXml, declared, exprNeedInfo.libraries, errorsInfo); //Подключение библиотек пользовательских типов данных
+            exprNeedInfo.atoms = typeLibraryCache().copyAtoms(); //Начать таблицу строк с атомов библиотек, чтобы идентификаторы их типов данных совпадали
+        }
+        if(errorsInfo.empty() && isNotEmpty ){
+            variablesInfo = readVarsInfoFromXML(xmlDoc, exprNeedInfo.atoms, exprNeedInfo.types, exprNeedInfo.declarations, declared, errorsInfo); //Считывание информации о переменных
+        }
+        if(errorsInfo.empty()){
+            functionsInfo = readFuncInfoFromXML(xmlDoc, exprNeedInfo.atoms, exprNeedInfo.types, exprNeedInfo.declarations, declared, errorsInfo);//Считывание информации о функциях
+            if(errorsInfo.empty()){
+                customDataInfo = readCustomDataInfoFromXML(xmlDoc, exprNeedInfo.atoms, exprNeedInfo.types, exprNeedInfo.declarations, declared, errorsInfo);// Считывание информации о пользовательских типах данных
+            }
+        }
+    }
+
+    //Если не возникло ошибок чтения xml дерева
+    if(errorsInfo.empty()){
+        exprNeedInfo.variablesInfo = variablesInfo;
+        exprNeedInfo.functionsInfo = functionsInfo;
+        exprNeedInfo.customDataInfo = customDataInfo;
+    }
+
+    //Построить таблицу символов для разрешения идентификаторов
+    if(errorsInfo.empty()){
+        buildSymbolTable(exprNeedInfo);
+    }
+
+    std::string strExpAndText; //Строка с выражением и текстовой записью пути
+    std::string_view strExp; //Строка с выражением (часть strExpAndText)
+    std::string_view strText;//Строка с текстовой записью пути (часть strExpAndText)
+
+    int numStr = 0; //Кол-во строк в txt файле
+
+    if(errorsInfo.empty()){
+        readFileContent(pathExp, strExpAndText, errorsInfo); //Считать информацию из txt файла
+        //Определить кол-во строк в txt файле
+        if(errorsInfo.empty()){
+            for(int i = 0; i<strExpAndText.size(); i++){
+                if(strExpAndText[i] == '\n'){
+                    numStr++;
+                }
+            }
+            if(numStr == 2){
+                //Разделение информации из файла на строку с выражением и строку с текстовой записью
+                std::string_view buf = strExpAndText;
+                size_t expEnd = buf.find('\n');
+                strExp = buf.substr(0, expEnd);
+                strText = buf.substr(expEnd + 1, buf.find('\n', expEnd + 1) - expEnd - 1);
+            } else{errorsInfo.push_back(ErrorInfo{ERROR_NO_EXPRESSION_AND_TEXT, {}});} //Считать, что возникла ошибка при чтение информации из txt файла
+        }
+    }
+
+    TreeNode* expTree = nullptr; //Дерево выражения
+
+    if(errorsInfo.empty()){
+
+        std::vector<std::string_view> subStrExp;
+
+        splitExprToSubstr(strExp, subStrExp); //Разделить выражение в обратной польской записи на подстроки разделеные пробелами
+
+        expTree = convertAnExpressionToTree (subStrExp, exprNeedInfo, trees, errorsInfo); //Сборка дерева выражения
+
+        if(errorsInfo.empty() && expTree != nullptr){
+
+            conv_combineAddMulOperators(expTree, trees); //Схлопнуть коммутативные операторы
+
+            conv_sort(expTree, exprNeedInfo.atoms); //Отсортировать дерево
+
+            annotateStaticTypes(expTree, exprNeedInfo, staticTypes); //Определить статические типы вершин дерева
+
+            bringTreeToStandartForm(expTree, exprNeedInfo, staticTypes, strExp, errorsInfo); //Привести дерево к эквивалентному виду
+
+            internTree(expTree, shapes); //Добавить структуры поддеревьев в DAG задания
+        }
+    }
+
+    TreeNode* textTree = nullptr; //Дерево по текстовой записи пути
+
+    if(errorsInfo.empty() && expTree != nullptr){
+
+        textTree = convertTextToTree (strText, exprNeedInfo.atoms, trees, errorsInfo); //Сборка дерево по текстовой записи пути
+
+        if(errorsInfo.empty()){
+
+            conv_combineAddMulOperators(textTree, trees);
+
+            conv_sort(textTree, exprNeedInfo.atoms);
+
+            internTree(textTree, shapes);
+        }
+    }
+
+    bool isEqualTrees = false; //Эквивалентны ли деревья
+    bool oneNode; //Является ли дерево - узлом
+
+    if(errorsInfo.empty() && expTree != nullptr && textTree != nullptr){
+        oneNode = textTree->nodes.size() == 0 || expTree->nodes.size() == 0;
+
+        if(errorsInfo.empty()){
+            //Полностью совпадающие деревья имеют одну структуру в DAG задания, и им не нужен поиск места ошибки
+            isEqualTrees = shapes.shapeOf(textTree) == shapes.shapeOf(expTree) || compareTextTreeAndExpressionTree(textTree, expTree, errorMessage, exprNeedInfo, staticTypes, shapes, oneNode); //Сравнение деревьев
+            convertTreeToString(expTree, exprNeedInfo.atoms, strout, caret);
+        }
+    }
+
+    //Деревья больше не нужны - освободить все их вершины и структуры разом
+    trees.reset();
+    shapes.clear();
+    staticTypes.clear();
+
+    return isEqualTrees;
+}
+
+void writeMessage(const std::string& nameOutFile, const QString& errorMessage, std::vector <ErrorInfo>& errorsInfo, const std::string& strout, int caret, const QString& exepath){
 
 
 
@@ -1528,13 +2247,8 @@ void writeMessage(std::string nameOutFile, QString errorMessage, std::vector <Er
                 out << message[i] << Qt::endl;
             }
         } else{
-            int pos =strOut.indexOf("#");
-            strOut.remove("#");
             finalErrorMessage.append(strOut + ":" + errorMessage);
-            QString bufStr;
-            for(int i = 0; i<pos-1; i++){
-                bufStr.prepend(" ");
-            }
+            QString bufStr(caret, QChar(' '));
             bufStr.append("^");
             finalErrorMessage.append(bufStr);
             for(int i = 0; i < finalErrorMessage.count(); i++){
@@ -21,29 +21,79 @@ void readFileContent (const std::string& filePath, std::string& fileContent, std
  */
 bool readXMLTreeFromFile(const std::string& xmlFilePath, tinyxml2::XMLDocument& xmlDoc,  std::vector<ErrorInfo>&errorsInfo);
 
+/*!
+ * \brief Функция получения библиотек пользовательских типов данных, загруженных за время работы процесса
+ * \return Общий для всех контекстов набор библиотек
+ */
+TypeLibraryCache& typeLibraryCache();
+
+/*!
+ * \brief Функция загрузки библиотеки пользовательских типов данных (при повторном обращении к неизмененному файлу возвращается уже загруженная,
+ * библиотека с ошибками и измененный файл читаются заново)
+ * \param [in] libraryPath - абсолютный путь к XML файлу библиотеки
+ * \param [out] errorsInfo - набор описаний ошибок при чтении библиотеки
+ * \return Загруженная библиотека (nullptr при циклическом подключении); прежняя версия измененного файла освобождается, когда ее отпустят все владельцы
+ */
+std::shared_ptr<const TypeLibrary> loadTypeLibrary(const std::string& libraryPath, std::vector<ErrorInfo>&errorsInfo);
+
+/*!
+ * \brief Функция подключения библиотек пользовательских типов данных, заданных узлами <include href="..."/>
+ * \param [in] docXML - XML дерево с подключениями библиотек
+ * \param [in] xmlFilePath - путь к XML файлу, от каталога которого отсчитываются относительные пути библиотек
+ * \param [in|out] declared - имена уже прочитанных объявлений, в которые добавляются имена типов данных библиотек
+ * \param [out] libraries - подключенные библиотеки (владелец удерживает их, пока ссылается на их типы данных)
+ * \param [out] errorsInfo - набор описаний ошибок при чтении библиотек
+ * \return Набор пользовательских типов данных подключенных библиотек (атомы из таблицы строк typeLibraryCache)
+ */
+const std::vector<CustomDataInfo*> readIncludesFromXML(const tinyxml2::XMLDocument& docXML, const std::string& xmlFilePath, DeclaredNames& declared, std::vector<std::shared_ptr<const TypeLibrary>>& libraries, std::vector<ErrorInfo>&errorsInfo);
+
 /*!
  * \brief Функция выделения информации о переменных
  * \param [in] docXML - XML дерево с описанием необходимых данных о переменных, функциях, пользовательских типах данных
+ * \param [in|out] atoms - таблица строк, в которую добавляются идентификаторы
+ * \param [in|out] types - пул типов данных, в который добавляются типы данных объявлений
+ * \param [in|out] declarations - хранилище, в котором размещаются прочитанные объявления
+ * \param [in|out] declared - имена уже прочитанных объявлений, в которые добавляются имена переменных
  * \param [out] errorsInfo - набор описаний ошибок при чтении файла
  * \return Набор информации о переменных
  */
-const std::vector<VariableInfo*> readVarsInfoFromXML(const tinyxml2::XMLDocument& docXML,  std::vector<ErrorInfo>&errorsInfo);
+const std::vector<VariableInfo*> readVarsInfoFromXML(const tinyxml2::XMLDocument& docXML, StringInterner& atoms, DataTypePool& types, DeclarationStore& declarations, DeclaredNames& declared, std::vector<ErrorInfo>&errorsInfo);
+
+/*!
+ * \brief Функция чтения необязательного списка параметров функции или метода
+ * \param [in] callableNode - узел XML дерева с описанием функции или метода
+ * \param [in|out] atoms - таблица строк, в которую добавляются идентификаторы
+ * \param [in|out] types - пул типов данных, в который добавляются типы данных параметров
+ * \param [out] arity - количество параметров (ANY_ARITY, если список параметров не задан)
+ * \param [out] paramTypes - типы данных параметров
+ * \param [out] wrongType - некорректный тип данных параметра
+ * \return Корректны ли типы данных всех параметров
+ */
+bool readParamTypesFromXML(const tinyxml2::XMLElement* callableNode, StringInterner& atoms, DataTypePool& types, int& arity, std::vector<const DataType*>& paramTypes, QString& wrongType);
 
 /*!
  * \brief Функция выделения информации о функциях
  * \param [in] docXML - XML дерево с описанием необходимых данных о переменных, функциях, пользовательских типах данных
+ * \param [in|out] atoms - таблица строк, в которую добавляются идентификаторы
+ * \param [in|out] types - пул типов данных, в который добавляются типы данных объявлений
+ * \param [in|out] declarations - хранилище, в котором размещаются прочитанные объявления
+ * \param [in|out] declared - имена уже прочитанных объявлений (переменные читаются раньше функций, поэтому совпадение имен функции и переменной проверяется здесь), в которые добавляются имена функций
  * \param [out] errorsInfo - набор описаний ошибок при чтении файла
  * \return Набор информации о функциях
  */
-const std::vector<FunctionInfo*> readFuncInfoFromXML(const tinyxml2::XMLDocument& docXML,  std::vector<ErrorInfo>&errorsInfo);
+const std::vector<FunctionInfo*> readFuncInfoFromXML(const tinyxml2::XMLDocument& docXML, StringInterner& atoms, DataTypePool& types, DeclarationStore& declarations, DeclaredNames& declared, std::vector<ErrorInfo>&errorsInfo);
 
 /*!
  * \brief Функция выделения информации о пользовательских типах данных
  * \param [in] docXML - XML дерево с описанием необходимых данных о переменных, функциях, пользовательских типах данных
+ * \param [in|out] atoms - таблица строк, в которую добавляются идентификаторы
+ * \param [in|out] types - пул типов данных, в который добавляются типы данных объявлений
+ * \param [in|out] declarations - хранилище, в котором размещаются прочитанные объявления
+ * \param [in|out] declared - имена уже прочитанных объявлений, в которые добавляются имена пользовательских типов данных
  * \param [out] errorsInfo - набор описаний ошибок при чтении файла
  * \return Набор информации о пользовательских типах данных
  */
-const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XMLDocument& docXML,  std::vector<ErrorInfo>&errorsInfo);
+const std::vector <CustomDataInfo*> readCustomDataInfoFromXML(const tinyxml2::XMLDocument& docXML, StringInterner& atoms, DataTypePool& types, DeclarationStore& declarations, DeclaredNames& declared, std::vector<ErrorInfo>&errorsInfo);
 
 /*!
 * \brief Функция проверка корректности типов данных
@@ -68,57 +118,167 @@ bool isCppKeyword(const QString &str);
 
 /*!
 * \brief Функция перевода обратной польской записи в дерево
-* \param [in] strs - исходные подстроки выражения
-* \param [in] expressionNeededInfo - необходимая информация для обработки выражения
+* \param [in] strs - исходные подстроки выражения (представления строки выражения, которая должна жить дольше вызова)
+* \param [in|out] eni - необходимая информация: в таблицу строк добавляются идентификаторы, по таблице сигнатур проверяются вызовы функций
+* \param [in|out] arena - память задания, в которой создаются вершины дерева
 * \param [out] errorsInfo - набор ошибок при выполнении функции
-* \return  Указатель на вершину полученного дерева
+* \return  Указатель на вершину полученного дерева, nullptr если в выражении не осталось ни одного операнда
 */
-TreeNode* convertAnExpressionToTree (std::vector<std::string> strs, std::vector <ErrorInfo>& errorsInfo);
+TreeNode* convertAnExpressionToTree (const std::vector<std::string_view>& strs, ExpressionNeededInfo& eni, TreeArena& arena, std::vector <ErrorInfo>& errorsInfo);
 
 /*!
 * \brief Функция получения строкового представления по дереву
 * \param [in] tree - дерево для преобразования
+* \param [in] atoms - таблица строк идентификаторов дерева
 * \param [out] path - пошаговый путь
+* \param [out] caret - смещение указателя на ошибку пользователя (вершину с меткой marked), 0 при ее отсутствии
 */
-void convertTreeToString(TreeNode* tree, std::string& strout);
+void convertTreeToString(TreeNode* tree, const StringInterner& atoms, std::string& strout, int& caret);
 
 /*!
-* \brief Функция для определения является ли поданная строка константой
+* \brief Функция для определения является ли поданная строка константой (цифры, не более одной десятичной точки)
 * \param [in] str - строка с предпологаемой константой
 * \return  Может ли строка являться константой
 */
-bool isConstant(std::string& str);
+bool isConstant(std::string_view str);
+
+/*!
+* \brief Функция записи в вершину константы: без десятичной точки - целочисленной, иначе вещественной
+* \param [in] str - строка, для которой isConstant истинно
+* \param [out] node - вершина, становящаяся константой
+*/
+void parseConstant(std::string_view str, TreeNode* node);
 
 /*!
 * \brief Функция разбиения поданной строки на подстроки разделенные пробелами
 * \param [in] expStr - строка из которой необходимо выделить подстроки
-* \param [out] strs - вектор подстрок
+* \param [out] strs - вектор подстрок (представления строки expStr без копирования)
+*/
+void splitExprToSubstr(std::string_view expStr, std::vector<std::string_view>& strs);
+
+/*!
+* \brief Функция преобразования представления строки в QString
+* \param [in] str - представление строки в UTF-8
+* \return  Строка Qt
+*/
+QString toQString(std::string_view str);
+
+/*!
+* \brief Функция разрешения типа данных: подсчет уровней указателей, размерностей массива и поиск пользовательского типа данных
+* \param [in] dataType - тип данных (в том числе указатель или массив)
+* \param [in] symbols - таблица символов с пользовательскими типами данных
+* \return Разрешенный тип данных
+*/
+ResolvedType resolveType(const DataType& dataType, const SymbolTable& symbols);
+
+/*!
+* \brief Функция разрешения типов полей и методов и построения таблиц членов пользовательских типов данных
+* \param [in|out] customDataInfo - пользовательские типы данных, в которые записываются таблицы членов
+* \param [in] symbols - таблица символов с пользовательскими типами данных
+*/
+void buildMemberTables(const std::vector<CustomDataInfo*>& customDataInfo, const SymbolTable& symbols);
+
+/*!
+* \brief Функция построения таблицы символов и разрешения типов всех объявлений по необходимой информации
+* \param [in|out] eni - необходимая информация, в которую записываются таблица символов и разрешенные типы
+*/
+void buildSymbolTable(ExpressionNeededInfo& eni);
+
+/*!
+* \brief Функция поиска члена пользовательского типа данных в его таблице членов
+* \param [in] custom - пользовательский тип данных
+* \param [in] member - вершина с именем поля или вызовом метода
+* \return Объявление поля или метода, nullptr если член не найден
 */
-void splitExprToSubstr(const std::string& expStr, std::vector<std::string>& strs);
+const SymbolInfo* findMember(const CustomDataInfo* custom, const TreeNode* member);
+
+/*!
+* \brief Функция определения статических типов всех вершин дерева (обход в обратном порядке)
+* \param [in] tree - указатель на вершину дерева
+* \param [in] eni - необходимая информация с построенной таблицей символов
+* \param [in|out] staticTypes - таблица, в которую записываются статические типы вершин дерева
+*/
+void annotateStaticTypes(TreeNode* tree, const ExpressionNeededInfo& eni, StaticTypeTable& staticTypes);
+
+/*!
+* \brief Функция определения статического типа вершины по уже определенным типам ее дочерних вершин
+* \param [in] tree - вершина, тип которой определяется (у доступа к члену - также тип члена)
+* \param [in] eni - необходимая информация с построенной таблицей символов
+* \param [in|out] staticTypes - таблица статических типов вершин с уже определенными типами дочерних вершин
+*/
+void annotateNodeStaticType(TreeNode* tree, const ExpressionNeededInfo& eni, StaticTypeTable& staticTypes);
+
+/*!
+* \brief Функция вычисления значения целочисленной вершины по уже вычисленным значениям ее операндов
+* \param [in|out] tree - указатель на вершину, в которой заполняются isFoldedConstant и intValue (вершина не вычисляется при делении на 0 и переполнении long long)
+* \param [in] staticTypes - статические типы вершин дерева
+*/
+void foldIntegerConstant(TreeNode* tree, const StaticTypeTable& staticTypes);
+
+/*!
+* \brief Функция определения имени массива, к элементу которого идет обращение
+* \param [in] arrayNode - операнд-массив операции доступа к элементу массива
+* \return Атом имени массива (EMPTY_ATOM, если массив не является переменной)
+*/
+Atom findArrayName(TreeNode* arrayNode);
+
+/*!
+* \brief Функция определения имени переменной или функции, с которой начинается операнд (A в A[1].b, f в f(x)->y)
+* \param [in] operand - операнд
+* \return Атом имени переменной или функции (EMPTY_ATOM, если операнд начинается с константы)
+*/
+Atom findRootName(TreeNode* operand);
 
 /*!
 * \brief Функция приведения дерева к эквивалентному виду
-* \param [in|out] tree - указатель на вершину приводимого дерева
+* \param [in|out] tree - указатель на вершину приводимого дерева с определенными статическими типами вершин
 * \param [in] expressionNeededInfo - необходимая информация для обработки дерева
+* \param [in] staticTypes - статические типы вершин дерева
 * \param [in] polsk - строка с обратной польской записью
 */
-void bringTreeToStandartForm(TreeNode* tree, ExpressionNeededInfo& expressionNeededInfo, std::string& polsk, std::vector<ErrorInfo>& errorList);
+void bringTreeToStandartForm(TreeNode* tree, ExpressionNeededInfo& expressionNeededInfo, const StaticTypeTable& staticTypes, std::string_view polsk, std::vector<ErrorInfo>& errorList);
+
+/*!
+* \brief Функция приведения вершины к эквивалентному виду, дочерние вершины которой уже приведены
+* \param [in|out] tree - приводимая вершина
+* \param [in] expressionNeededInfo - необходимая информация для обработки дерева
+* \param [in] staticTypes - статические типы вершин дерева
+* \param [in] polsk - строка с обратной польской записью
+* \param [out] errorList - набор ошибок в выражении
+*/
+void bringNodeToStandartForm(TreeNode* tree, ExpressionNeededInfo& expressionNeededInfo, const StaticTypeTable& staticTypes, std::string_view polsk, std::vector<ErrorInfo>& errorList);
 
 /*!
 * \brief Функция перевода текстовой записи пути в дерево
 * \param [in] textPath - исходная строка с текстовой записью
+* \param [in|out] atoms - таблица строк, в которую добавляются идентификаторы
+* \param [in|out] arena - память задания, в которой создаются вершины дерева
 * \param [out] errorsInfo - набор ошибок при выполнении функции
 * \return  Указатель на вершину полученного дерева
 */
-TreeNode* convertTextToTree (std::string textPath,  std::vector <ErrorInfo>& errorsInfo);
+TreeNode* convertTextToTree (std::string_view textPath, StringInterner& atoms, TreeArena& arena, std::vector <ErrorInfo>& errorsInfo);
+
+/*!
+* \brief Функция построения вершины по шаблону текстовой записи и уже построенным аргументам
+* \param [in] pattern - текстовая запись без аргументов в фигурных скобках
+* \param [in|out] childs - вершины аргументов в порядке записи (используются при построении)
+* \param [in|out] atoms - таблица строк, в которую добавляются идентификаторы
+* \param [in|out] arena - память задания, в которой создаются вершины дерева
+* \param [out] errorsInfo - набор ошибок при выполнении функции
+* \return  Указатель на построенную вершину
+*/
+TreeNode* buildTextNode(const std::string& pattern, std::vector<TreeNode*>& childs, StringInterner& atoms, TreeArena& arena, std::vector <ErrorInfo>& errorsInfo);
 
 /*!
 * \brief Функция сравнения деревьев
 * \param [in] tree1 - указатель на вершину первого дерева
 * \param [in] tree2 - указатель на вершину второго дерева
+* \param [in] atoms - таблица строк идентификаторов деревьев
+* \param [in] shapes - DAG структур поддеревьев задания (структурно равные поддеревья не обходятся)
+* \param [out] pass - путь до первого отличия
 * \return  Являются ли деревья равными
 */
-bool compareTrees(TreeNode* tree1, TreeNode* tree2);
+bool compareTrees(TreeNode* tree1, TreeNode* tree2, const StringInterner& atoms, const TreeShapePool& shapes, std::string& pass);
 
 /*!
 * \brief Функция определения цепочки отличных от указанного узла
@@ -130,14 +290,21 @@ void getNearDiffOperands(TreeNode* tree, std::vector<TreeNode*>& operands);
 /*!
 * \brief Функция схлопывания цепочек коммутативных операторов
 * \param [in|out] tree - указатель на исследуемое дерево
+* \param [in|out] arena - память задания для операндов объединенных операторов
 */
-void conv_combineAddMulOperators(TreeNode* tree);
+void conv_combineAddMulOperators(TreeNode* tree, TreeArena& arena);
 
 /*!
-* \brief Функция сортировки дерева
+* \brief Функция сортировки дерева: упорядочивание операндов коммутативных операторов
+*
+* Раньше идут константы (по значению, целочисленная раньше равной ей вещественной), затем переменные (по имени),
+* затем операторы (по виду оператора, количеству операндов, имени вызываемой функции и далее по операндам слева направо).
+* Порядок определяется только деревом и не зависит от порядка объявлений: например, p q - r - p q - s - + записывается как p-q-r+p-q-s.
+* Порядок отличается от алфавитного порядка строковых представлений: например, a c * b + записывается как b+a*c
 * \param [in|out] tree - указатель на узел исследуемого дерева
+* \param [in] atoms - таблица строк идентификаторов дерева
 */
-void conv_sort(TreeNode* tree);
+void conv_sort(TreeNode* tree, const StringInterner& atoms);
 
 /*!
 * \brief Функция определения является ли подданая строка шаблоном и определение операции данного шаблона
@@ -153,17 +320,38 @@ bool is_template(const QString &str, templates &temp);
 * \param [in] tree2 - дерево по выражению
 * \param [out] errorString - строка с ошибкой
 * \param [in] eni - необходимая информация
+* \param [in] staticTypes - статические типы вершин дерева выражения
+* \param [in] shapes - DAG структур поддеревьев задания (структурно равные поддеревья не обходятся)
 * \param [in] oneNode - признак того, что дерево состоит из одной вершины
 * \return Могут ли деревья быть эквивалентными
 */
-bool compareTextTreeAndExpressionTree(TreeNode* tree1, TreeNode* tree2, QString& errorString, ExpressionNeededInfo& eni, const bool oneNode);
+bool compareTextTreeAndExpressionTree(TreeNode* tree1, TreeNode* tree2, QString& errorString, ExpressionNeededInfo& eni, const StaticTypeTable& staticTypes, const TreeShapePool& shapes, const bool oneNode);
 
 /*!
-* \brief Функция проверки необходимой информации
-* \param [in] eni - необходимая информация
-* \param [out] errorList - список ошибок при обработке необходимой информации
+* \brief Функция добавления структур всех поддеревьев дерева в DAG задания
+* \param [in] tree - дерево
+* \param [in|out] shapes - DAG структур поддеревьев задания, в который записываются структуры поддеревьев всех вершин дерева
+* \return Структура всего дерева
 */
-void checkENIOncopyInXML(ExpressionNeededInfo& eni, std::vector<ErrorInfo>& errorList);
+const TreeShape* internTree(TreeNode* tree, TreeShapePool& shapes);
+
+
+/*!
+* \brief Функция выполнения задания: загрузка контекста из XML файла, построение деревьев выражения и текстовой записи пути из txt файла,
+* приведение и сравнение деревьев. Память задания, DAG и статические типы освобождаются в конце задания и переиспользуются следующим
+* \param [in] pathExp - путь к txt файлу с выражением и текстовой записью пути
+* \param [in] pathXml - путь к XML файлу с необходимой информацией для обработки выражения
+* \param [in|out] trees - память задания, в которой создаются вершины обоих деревьев
+* \param [in|out] shapes - DAG структур поддеревьев обоих деревьев задания
+* \param [in|out] staticTypes - статические типы вершин дерева выражения
+* \param [out] errorMessage - сообщение об ошибке в прохождении пути
+* \param [out] strout - строковое представление выражения
+* \param [out] caret - смещение указателя на ошибку пользователя в строковом представлении выражения
+* \param [out] errorsInfo - набор ошибок во входных данных
+* \return Эквивалентны ли деревья
+*/
+bool runJob(const std::string& pathExp, const std::string& pathXml, TreeArena& trees, TreeShapePool& shapes, StaticTypeTable& staticTypes, QString& errorMessage, std::string& strout, int& caret, std::vector<ErrorInfo>& errorsInfo);
+
 
 
 /*!
@@ -172,6 +360,7 @@ void checkENIOncopyInXML(ExpressionNeededInfo& eni, std::vector<ErrorInfo>& erro
 * \param [in] errorMessage - сообщение об ошибке пользователя
 * \param [in] errorsInfo - сообщение об ошибке во входных данных
 * \param [in] strout - текстовое представление пути
+* \param [in] caret - смещение указателя на ошибку пользователя в текстовом представлении пути
 * \param [in] exepath - путь к исполняемому файлу
 */
-void writeMessage(std::string nameOutFile, QString errorMessage, std::vector <ErrorInfo>& errorsInfo, std::string strout, QString exepath);
+void writeMessage(const std::string& nameOutFile, const QString& errorMessage, std::vector <ErrorInfo>& errorsInfo, const std::string& strout, int caret, const QString& exepath);
@@ -24,6 +24,7 @@ distribution.
 #include "tinyxml2.h"
 
 #include <new>		// yes, this one new style header, is in the Android SDK.
+#include <charconv>
 #if defined(ANDROID_NDK) || defined(__BORLANDC__) || defined(__QNXNTO__)
 #   include <stddef.h>
 #   include <stdarg.h>
@@ -675,6 +676,52 @@ bool XMLUtil::ToUnsigned64(const char* str, uint64_t* value) {
 }
 
 
+bool XMLUtil::ToIntList(const char* str, int* values, int capacity, int* count, int* errorOffset)
+{
+	TIXMLASSERT(str);
+	TIXMLASSERT(values);
+	TIXMLASSERT(count);
+	const char* const end = str + strlen(str);
+	const char* p = str;
+	bool ok = true;
+	int n = 0;
+
+	for (;;) {
+		while (p < end && IsWhiteSpace(*p)) {
+			++p;
+		}
+		if (n == capacity) {
+			ok = false;
+			break;
+		}
+		const std::from_chars_result result = std::from_chars(p, end, values[n]);
+		if (result.ec != std::errc()) {
+			ok = false;
+			break;
+		}
+		++n;
+		p = result.ptr;
+		while (p < end && IsWhiteSpace(*p)) {
+			++p;
+		}
+		if (p == end) {
+			break;
+		}
+		if (*p != ',') {
+			ok = false;
+			break;
+		}
+		++p;
+	}
+
+	*count = n;
+	if (!ok && errorOffset) {
+		*errorOffset = static_cast<int>(p - str);
+	}
+	return ok;
+}
+
+
 char* XMLDocument::Identify( char* p, XMLNode** node )
 {
     TIXMLASSERT( node );
@@ -817,7 +864,25 @@ void XMLNode::DeleteChildren()
 {
     while( _firstChild ) {
         TIXMLASSERT( _lastChild );
-        DeleteChild( _firstChild );
+        XMLNode* child = _firstChild;
+        // Lift the grandchildren up to this level before deleting the child,
+        // so that a deep tree is torn down without recursion.
+        if ( child->_firstChild ) {
+            for( XMLNode* node = child->_firstChild; node; node = node->_next ) {
+                node->_parent = this;
+            }
+            child->_lastChild->_next = child->_next;
+            if ( child->_next ) {
+                child->_next->_prev = child->_lastChild;
+            }
+            else {
+                _lastChild = child->_lastChild;
+            }
+            child->_next = child->_firstChild;
+            child->_firstChild->_prev = child;
+            child->_firstChild = child->_lastChild = 0;
+        }
+        DeleteChild( child );
     }
     _firstChild = _lastChild = 0;
 }
@@ -1009,7 +1074,7 @@ const XMLElement* XMLNode::PreviousSiblingElement( const char* name ) const
 
 char* XMLNode::ParseDeep( char* p, StrPair* parentEndTag, int* curLineNumPtr )
 {
-    // This is a recursive method, but thinking about it "at the current level"
+    // This method is iterative, but thinking about it "at the current level"
     // it is a pretty simple flat list:
     //		<foo/>
     //		<!-- comment -->
@@ -1020,18 +1085,25 @@ char* XMLNode::ParseDeep( char* p, StrPair* parentEndTag, int* curLineNumPtr )
     //		<!-- comment -->
     //
     // Where the closing element (/foo) *must* be the next thing after the opening
-    // element, and the names must match. BUT the tricky bit is that the closing
-    // element will be read by the child.
+    // element, and the names must match.
+    //
+    // Instead of recursing into every open element, the open elements are kept
+    // on an explicit stack. The top of the stack is the element whose children
+    // are being read; when its closing element is found it is popped and
+    // attached to the element below it (or to 'this'). So the nesting depth
+    // is limited by the heap, not by the call stack.
     //
-    // 'endTag' is the end tag for this node, it is returned by a call to a child.
-    // 'parentEnd' is the end tag for the parent, which is filled in and returned.
+    // 'parentEnd' is the end tag for the parent of 'this', which is filled in
+    // and returned when a closing element is found at the level of 'this'.
 
-	XMLDocument::DepthTracker tracker(_document);
 	if (_document->Error())
 		return 0;
 
+    DynArray<XMLElement*, 16> openElements;
+
 	while( p && *p ) {
         XMLNode* node = 0;
+        XMLNode* const parent = openElements.Empty() ? this : openElements.PeekTop();
 
         p = _document->Identify( p, &node );
         TIXMLASSERT( p );
@@ -1041,8 +1113,14 @@ char* XMLNode::ParseDeep( char* p, StrPair* parentEndTag, int* curLineNumPtr )
 
        const int initialLineNum = node->_parseLineNum;
 
-        StrPair endTag;
-        p = node->ParseDeep( p, &endTag, curLineNumPtr );
+        XMLElement* ele = node->ToElement();
+        if ( ele ) {
+            p = ele->ParseStartTag( p, curLineNumPtr );
+        }
+        else {
+            StrPair endTag;
+            p = node->ParseDeep( p, &endTag, curLineNumPtr );
+        }
         if ( !p ) {
             DeleteNode( node );
             if ( !_document->Error() ) {
@@ -1063,13 +1141,13 @@ char* XMLNode::ParseDeep( char* p, StrPair* parentEndTag, int* curLineNumPtr )
             // declarations have so far been added.
             bool wellLocated = false;
 
-            if (ToDocument()) {
-                if (FirstChild()) {
+            if (parent->ToDocument()) {
+                if (parent->FirstChild()) {
                     wellLocated =
-                        FirstChild() &&
-                        FirstChild()->ToDeclaration() &&
-                        LastChild() &&
-                        LastChild()->ToDeclaration();
+                        parent->FirstChild() &&
+                        parent->FirstChild()->ToDeclaration() &&
+                        parent->LastChild() &&
+                        parent->LastChild()->ToDeclaration();
                 }
                 else {
                     wellLocated = true;
@@ -1082,41 +1160,56 @@ char* XMLNode::ParseDeep( char* p, StrPair* parentEndTag, int* curLineNumPtr )
             }
         }
 
-        XMLElement* ele = node->ToElement();
         if ( ele ) {
-            // We read the end tag. Return it to the parent.
             if ( ele->ClosingType() == XMLElement::CLOSING ) {
-                if ( parentEndTag ) {
-                    ele->_value.TransferTo( parentEndTag );
+                if ( openElements.Empty() ) {
+                    // We read the end tag of the parent of 'this'. Return it.
+                    if ( parentEndTag ) {
+                        ele->_value.TransferTo( parentEndTag );
+                    }
+                    node->_memPool->SetTracked();   // created and then immediately deleted.
+                    DeleteNode( node );
+                    return p;
                 }
+
+                // The end tag closes the element on top of the stack.
+                XMLElement* const closed = openElements.Pop();
+                const bool mismatch = !XMLUtil::StringEqual( ele->Name(), closed->Name() );
                 node->_memPool->SetTracked();   // created and then immediately deleted.
                 DeleteNode( node );
-                return p;
-            }
-
-            // Handle an end tag returned to this level.
-            // And handle a bunch of annoying errors.
-            bool mismatch = false;
-            if ( endTag.Empty() ) {
-                if ( ele->ClosingType() == XMLElement::OPEN ) {
-                    mismatch = true;
+                if ( mismatch ) {
+                    _document->SetError( XML_ERROR_MISMATCHED_ELEMENT, closed->_parseLineNum, "XMLElement name=%s", closed->Name());
+                    DeleteNode( closed );
+                    break;
                 }
+                ( openElements.Empty() ? this : openElements.PeekTop() )->InsertEndChild( closed );
+                continue;
             }
-            else {
-                if ( ele->ClosingType() != XMLElement::OPEN ) {
-                    mismatch = true;
-                }
-                else if ( !XMLUtil::StringEqual( endTag.GetStr(), ele->Name() ) ) {
-                    mismatch = true;
+
+            if ( ele->ClosingType() == XMLElement::OPEN ) {
+                // An open element at the very end of the input can never be closed.
+                if ( !*p ) {
+                    _document->SetError( XML_ERROR_MISMATCHED_ELEMENT, initialLineNum, "XMLElement name=%s", ele->Name());
+                    DeleteNode( node );
+                    break;
                 }
-            }
-            if ( mismatch ) {
-                _document->SetError( XML_ERROR_MISMATCHED_ELEMENT, initialLineNum, "XMLElement name=%s", ele->Name());
-                DeleteNode( node );
-                break;
+                // Read its children before attaching it to the parent.
+                openElements.Push( ele );
+                continue;
             }
         }
-        InsertEndChild( node );
+        parent->InsertEndChild( node );
+    }
+
+    // The input ended (or an error occurred) while some elements were still
+    // open. Drop them innermost first, as the nested levels would have done.
+    while ( !openElements.Empty() ) {
+        XMLElement* const unclosed = openElements.Pop();
+        const int unclosedLineNum = unclosed->_parseLineNum;
+        DeleteNode( unclosed );
+        if ( !_document->Error() ) {
+            _document->SetError( XML_ERROR_PARSING, unclosedLineNum, 0);
+        }
     }
     return 0;
 }
@@ -1472,6 +1565,15 @@ XMLError XMLAttribute::QueryDoubleValue( double* value ) const
 }
 
 
+XMLError XMLAttribute::QueryIntListValue( int* values, int capacity, int* count, int* errorOffset ) const
+{
+    if ( XMLUtil::ToIntList( Value(), values, capacity, count, errorOffset )) {
+        return XML_SUCCESS;
+    }
+    return XML_WRONG_ATTRIBUTE_TYPE;
+}
+
+
 void XMLAttribute::SetAttribute( const char* v )
 {
     _value.SetStr( v );
@@ -1999,6 +2101,18 @@ XMLUnknown* XMLElement::InsertNewUnknown(const char* text)
 //	<ele>foo<b>bar</b></ele>
 //
 char* XMLElement::ParseDeep( char* p, StrPair* parentEndTag, int* curLineNumPtr )
+{
+    p = ParseStartTag( p, curLineNumPtr );
+    if ( !p || !*p || _closingType != OPEN ) {
+        return p;
+    }
+
+    p = XMLNode::ParseDeep( p, parentEndTag, curLineNumPtr );
+    return p;
+}
+
+
+char* XMLElement::ParseStartTag( char* p, int* curLineNumPtr )
 {
     // Read the element name.
     p = XMLUtil::SkipWhiteSpace( p, curLineNumPtr );
@@ -2017,11 +2131,6 @@ char* XMLElement::ParseDeep( char* p, StrPair* parentEndTag, int* curLineNumPtr
     }
 
     p = ParseAttributes( p, curLineNumPtr );
-    if ( !p || !*p || _closingType != OPEN ) {
-        return p;
-    }
-
-    p = XMLNode::ParseDeep( p, parentEndTag, curLineNumPtr );
     return p;
 }
 
@@ -2116,7 +2225,6 @@ XMLDocument::XMLDocument( bool processEntities, Whitespace whitespaceMode ) :
     _errorLineNum( 0 ),
     _charBuffer( 0 ),
     _parseCurLineNum( 0 ),
-	_parsingDepth(0),
     _unlinked(),
     _elementPool(),
     _attributePool(),
@@ -2139,7 +2247,9 @@ void XMLDocument::MarkInUse(const XMLNode* const node)
 	TIXMLASSERT(node);
 	TIXMLASSERT(node->_parent == 0);
 
-	for (int i = 0; i < _unlinked.Size(); ++i) {
+	// Search from the end: the parser links nodes in roughly the reverse
+	// order it creates them, so the node is almost always found at once.
+	for (int i = _unlinked.Size() - 1; i >= 0; --i) {
 		if (node == _unlinked[i]) {
 			_unlinked.SwapRemove(i);
 			break;
@@ -2161,7 +2271,6 @@ void XMLDocument::Clear()
 
     delete [] _charBuffer;
     _charBuffer = 0;
-	_parsingDepth = 0;
 
 #if 0
     _textPool.Trace( "text" );
@@ -2496,20 +2605,6 @@ void XMLDocument::Parse()
     ParseDeep(p, 0, &_parseCurLineNum );
 }
 
-void XMLDocument::PushDepth()
-{
-	_parsingDepth++;
-	if (_parsingDepth == TINYXML2_MAX_ELEMENT_DEPTH) {
-		SetError(XML_ELEMENT_DEPTH_EXCEEDED, _parseCurLineNum, "Element nesting is too deep." );
-	}
-}
-
-void XMLDocument::PopDepth()
-{
-	TIXMLASSERT(_parsingDepth > 0);
-	--_parsingDepth;
-}
-
 XMLPrinter::XMLPrinter( FILE* file, bool compact, int depth ) :
     _elementJustOpened( false ),
     _stack(),
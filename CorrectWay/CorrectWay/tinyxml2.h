@@ -106,13 +106,6 @@ static const int TIXML2_PATCH_VERSION = 0;
 #define TINYXML2_MINOR_VERSION 0
 #define TINYXML2_PATCH_VERSION 0
 
-// A fixed element depth limit is problematic. There needs to be a
-// limit to avoid a stack overflow. However, that limit varies per
-// system, and the capacity of the stack. On the other hand, it's a trivial
-// attack that can result from ill, malicious, or even correctly formed XML,
-// so there needs to be a limit in place.
-static const int TINYXML2_MAX_ELEMENT_DEPTH = 100;
-
 namespace tinyxml2
 {
 class XMLDocument;
@@ -627,6 +620,9 @@ public:
     static bool ToDouble( const char* str, double* value );
 	static bool ToInt64(const char* str, int64_t* value);
     static bool ToUnsigned64(const char* str, uint64_t* value);
+	// Reads a comma separated list of integers ("3, 4") into 'values'.
+	// On failure 'errorOffset' is the offset in 'str' where reading stopped.
+	static bool ToIntList(const char* str, int* values, int capacity, int* count, int* errorOffset);
 	// Changes what is serialized for a boolean value.
 	// Default to "true" and "false". Shouldn't be changed
 	// unless you have a special testing or compatibility need.
@@ -1213,6 +1209,14 @@ public:
     XMLError QueryDoubleValue( double* value ) const;
     /// See QueryIntValue
     XMLError QueryFloatValue( float* value ) const;
+    /** QueryIntListValue interprets the attribute as a comma separated list of
+    	integers, such as "3,4". At most 'capacity' values are written to 'values'
+    	and their number to 'count'. Returns XML_SUCCESS on success, and
+    	XML_WRONG_ATTRIBUTE_TYPE if the list is malformed or longer than 'capacity';
+    	in that case 'errorOffset' (if not null) is the offset in the attribute
+    	value where reading stopped.
+    */
+    XMLError QueryIntListValue( int* values, int capacity, int* count, int* errorOffset = 0 ) const;
 
     /// Set the attribute to a string value.
     void SetAttribute( const char* value );
@@ -1258,6 +1262,7 @@ private:
 class TINYXML2_LIB XMLElement : public XMLNode
 {
     friend class XMLDocument;
+    friend class XMLNode;
 public:
     /// Get the name of an element (which is the Value() of the node.)
     const char* Name() const		{
@@ -1394,6 +1399,15 @@ public:
         return a->QueryFloatValue( value );
     }
 
+    /// See QueryIntAttribute() and XMLAttribute::QueryIntListValue()
+    XMLError QueryIntListAttribute( const char* name, int* values, int capacity, int* count, int* errorOffset = 0 ) const {
+        const XMLAttribute* a = FindAttribute( name );
+        if ( !a ) {
+            return XML_NO_ATTRIBUTE;
+        }
+        return a->QueryIntListValue( values, capacity, count, errorOffset );
+    }
+
 	/// See QueryIntAttribute()
 	XMLError QueryStringAttribute(const char* name, const char** value) const {
 		const XMLAttribute* a = FindAttribute(name);
@@ -1679,6 +1693,7 @@ private:
     void operator=( const XMLElement& );	// not supported
 
     XMLAttribute* FindOrCreateAttribute( const char* name );
+    char* ParseStartTag( char* p, int* curLineNumPtr );
     char* ParseAttributes( char* p, int* curLineNumPtr );
     static void DeleteAttribute( XMLAttribute* attribute );
     XMLAttribute* CreateAttribute();
@@ -1930,7 +1945,6 @@ private:
     int             _errorLineNum;
     char*			_charBuffer;
     int				_parseCurLineNum;
-	int				_parsingDepth;
 	// Memory tracking does add some overhead.
 	// However, the code assumes that you don't
 	// have a bunch of unlinked nodes around.
@@ -1950,23 +1964,6 @@ private:
 
     void SetError( XMLError error, int lineNum, const char* format, ... );
 
-	// Something of an obvious security hole, once it was discovered.
-	// Either an ill-formed XML or an excessively deep one can overflow
-	// the stack. Track stack depth, and error out if needed.
-	class DepthTracker {
-	public:
-		explicit DepthTracker(XMLDocument * document) {
-			this->_document = document;
-			document->PushDepth();
-		}
-		~DepthTracker() {
-			_document->PopDepth();
-		}
-	private:
-		XMLDocument * _document;
-	};
-	void PushDepth();
-	void PopDepth();
 
     template<class NodeType, int PoolElementSize>
     NodeType* CreateUnlinkedNode( MemPoolT<PoolElementSize>& pool );
@@ -0,0 +1,18 @@
+QT -= gui
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_expression
+
+INCLUDEPATH += ../../CorrectWay
+
+SOURCES += \
+        tst_expression.cpp \
+        ../../CorrectWay/function.cpp \
+        ../../CorrectWay/tinyxml2.cpp
+
+HEADERS += \
+    ../../CorrectWay/dataStructure.h \
+    ../../CorrectWay/function.h \
+    ../../CorrectWay/tinyxml2.h
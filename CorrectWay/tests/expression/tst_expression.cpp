@@ -0,0 +1,97 @@
+/*!
+*\file tst_expression.cpp
+*\brief Тест ошибок разбора выражения в обратной польской записи
+*/
+#include "function.h"
+
+/*!
+ * \brief Разобрать выражение и проверить коды возникших ошибок
+ * \param [in] name Название проверки
+ * \param [in] strs Подстроки выражения
+ * \param [in] expectTree Должно ли получиться дерево
+ * \param [in] expectErrors Ожидаемые коды ошибок в порядке их возникновения
+ * \return true, если результат разбора совпал с ожидаемым
+ */
+static bool checkExpression(const char* name, const std::vector<std::string_view>& strs, bool expectTree, const std::vector<ErrorCode>& expectErrors){
+    ExpressionNeededInfo exprNeedInfo;
+    buildSymbolTable(exprNeedInfo);
+    TreeArena trees;
+    std::vector<ErrorInfo> errorsInfo;
+
+    TreeNode* tree = convertAnExpressionToTree(strs, exprNeedInfo, trees, errorsInfo);
+
+    bool passed = (tree != nullptr) == expectTree && errorsInfo.size() == expectErrors.size();
+    for(size_t i = 0; passed && i < errorsInfo.size(); i++){
+        passed = errorsInfo[i].errorCode == expectErrors[i];
+    }
+    //Сообщение каждой ошибки должно собираться из ее содержимого
+    for(const ErrorInfo& error : errorsInfo){
+        passed = passed && !error.createErrorMessage().isEmpty();
+    }
+
+    if(!passed){
+        std::cout << name << ": tree " << (tree != nullptr ? "built" : "not built") << ", errors:";
+        for(const ErrorInfo& error : errorsInfo){
+            std::cout << " " << error.errorCodeName();
+        }
+        std::cout << std::endl;
+    }
+    return passed;
+}
+
+/*!
+ * \brief Отсортировать дерево выражения и проверить его строковое представление
+ * \param [in] name Название проверки
+ * \param [in] declared Идентификаторы, добавляемые в таблицу строк до разбора выражения (задают номера атомов)
+ * \param [in] strs Подстроки выражения
+ * \param [in] expectStr Ожидаемое строковое представление отсортированного дерева
+ * \return true, если представление совпало с ожидаемым
+ */
+static bool checkSortedExpression(const char* name, const std::vector<std::string_view>& declared, const std::vector<std::string_view>& strs, const std::string& expectStr){
+    ExpressionNeededInfo exprNeedInfo;
+    for(std::string_view id : declared){
+        exprNeedInfo.atoms.intern(id);
+    }
+    buildSymbolTable(exprNeedInfo);
+    TreeArena trees;
+    std::vector<ErrorInfo> errorsInfo;
+
+    TreeNode* tree = convertAnExpressionToTree(strs, exprNeedInfo, trees, errorsInfo);
+    std::string strTree;
+    int caret = 0;
+    if(tree != nullptr){
+        conv_combineAddMulOperators(tree, trees);
+        conv_sort(tree, exprNeedInfo.atoms);
+        convertTreeToString(tree, exprNeedInfo.atoms, strTree, caret);
+    }
+
+    if(strTree != expectStr){
+        std::cout << name << ": " << strTree << " instead of " << expectStr << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(){
+    bool passed = true;
+
+    //Выражение без подстрок не оставляет в стеке ни одного операнда
+    passed = checkExpression("empty expression", {}, false, {ERROR_ANALYZE_EXP_NO_OPERANDS}) && passed;
+
+    //Оператор без операндов сообщает о себе, а не о пустом выражении
+    passed = checkExpression("operator without operands", {"+"}, false, {ERROR_ANALYZE_EXP_MORE_OP}) && passed;
+
+    passed = checkExpression("extra operand", {"a", "b"}, true, {ERROR_ANALYZE_EXP_MORE_VAR}) && passed;
+
+    passed = checkExpression("correct expression", {"a", "b", "+"}, true, {}) && passed;
+
+    //Порядок операндов не зависит от порядка объявлений, даже если поддеревья совпадают в первых вершинах
+    const std::vector<std::string_view> sameHeads = {"p", "q", "-", "r", "-", "p", "q", "-", "s", "-", "+"};
+    passed = checkSortedExpression("declared p q r s", {"p", "q", "r", "s"}, sameHeads, "p-q-r+p-q-s") && passed;
+    passed = checkSortedExpression("declared p q s r", {"p", "q", "s", "r"}, sameHeads, "p-q-r+p-q-s") && passed;
+    passed = checkSortedExpression("declared s r q p", {"s", "r", "q", "p"}, sameHeads, "p-q-r+p-q-s") && passed;
+
+    if(passed)
+        std::cout << "PASS" << std::endl;
+    return passed ? 0 : 1;
+}
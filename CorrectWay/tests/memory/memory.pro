@@ -0,0 +1,18 @@
+QT -= gui
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_memory
+
+INCLUDEPATH += ../../CorrectWay
+
+SOURCES += \
+        tst_memory.cpp \
+        ../../CorrectWay/function.cpp \
+        ../../CorrectWay/tinyxml2.cpp
+
+HEADERS += \
+    ../../CorrectWay/dataStructure.h \
+    ../../CorrectWay/function.h \
+    ../../CorrectWay/tinyxml2.h
@@ -0,0 +1,157 @@
+/*!
+*\file tst_memory.cpp
+*\brief Регрессионный тест памяти при многократной перезагрузке контекста задания
+*
+* Задание (контекст из XML с подключенной библиотекой и выражение из txt файла) выполняется
+* много раз подряд тем же runJob, что и в программе, в том числе с изменением файла библиотеки
+* перед каждым заданием. После первого задания, заполняющего кэш библиотек и память задания,
+* объем занятой памяти не должен меняться.
+*/
+#include "function.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+
+/*!
+ * \brief Объем памяти, занятой через глобальный operator new, в байтах
+ */
+static size_t liveBytes = 0;
+
+/*!
+ * \brief Заголовок перед каждым выделенным блоком памяти (выровнен, как max_align_t)
+ */
+const size_t BLOCK_HEADER = alignof(std::max_align_t) > sizeof(size_t) ? alignof(std::max_align_t) : sizeof(size_t);
+
+void* operator new(size_t size){
+    char* block = (char*)std::malloc(size + BLOCK_HEADER);
+    if(block == nullptr)
+        throw std::bad_alloc();
+    *(size_t*)block = size;
+    liveBytes += size;
+    return block + BLOCK_HEADER;
+}
+
+void* operator new[](size_t size){
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept{
+    if(ptr == nullptr)
+        return;
+    char* block = (char*)ptr - BLOCK_HEADER;
+    liveBytes -= *(size_t*)block;
+    std::free(block);
+}
+
+void operator delete[](void* ptr) noexcept{
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept{
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept{
+    operator delete(ptr);
+}
+
+/*!
+ * \brief Количество повторных выполнений задания после первого
+ */
+const int RELOAD_COUNT = 100;
+
+/*!
+ * \brief Записать содержимое в файл
+ * \param [in] path Путь к файлу
+ * \param [in] content Содержимое файла
+ */
+static void writeFile(const std::filesystem::path& path, const char* content){
+    std::ofstream file(path);
+    file << content;
+}
+
+/*!
+ * \brief Проверить, что память не растет при повторном выполнении задания
+ * \param [in] name Название проверки
+ * \param [in] pathExp Путь к txt файлу с выражением и текстовой записью пути
+ * \param [in] pathXml Путь к XML файлу с объявлениями
+ * \param [in] expectErrors Должно ли задание завершаться ошибкой во входных данных
+ * \param [in] touchedLibrary Путь к библиотеке, время изменения которой сдвигается перед каждым заданием (пустой - не изменять)
+ * \return true, если память осталась неизменной и результат задания совпал с ожидаемым
+ */
+static bool checkMemoryIsFlat(const char* name, const std::string& pathExp, const std::string& pathXml, bool expectErrors, const std::filesystem::path& touchedLibrary){
+    TreeArena trees;
+    TreeShapePool shapes;
+    StaticTypeTable staticTypes;
+    size_t baseline = 0;
+
+    for(int i = 0; i <= RELOAD_COUNT; i++){
+        //Первое задание заполняет кэш библиотек и память задания
+        if(i == 1)
+            baseline = liveBytes;
+        if(!touchedLibrary.empty()){
+            std::filesystem::last_write_time(touchedLibrary, std::filesystem::last_write_time(touchedLibrary) + std::chrono::seconds(1));
+        }
+        QString errorMessage;
+        std::string strTree;
+        int caret = 0;
+        std::vector<ErrorInfo> errorsInfo;
+        runJob(pathExp, pathXml, trees, shapes, staticTypes, errorMessage, strTree, caret, errorsInfo);
+        if(errorsInfo.empty() == expectErrors){
+            std::cout << name << ": unexpected job result" << std::endl;
+            return false;
+        }
+    }
+
+    if(liveBytes != baseline){
+        std::cout << name << ": " << baseline << " bytes after the first job, " << liveBytes << " bytes after " << RELOAD_COUNT << " more" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(){
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "tst_memory";
+    std::filesystem::create_directories(dir);
+
+    writeFile(dir / "types.xml",
+              "<struct name=\"s\">\n"
+              "<field name=\"x\" typeF=\"int\"/>\n"
+              "</struct>\n"
+              "<class name = \"c\">\n"
+              "<field name = \"b\" typeF = \"int\"/>\n"
+              "<field name = \"d\" typeF = \"struct s\"/>\n"
+              "</class>\n");
+    writeFile(dir / "context.xml",
+              "<include href=\"types.xml\"/>\n"
+              "<variables>\n"
+              "<var name = \"a\" type = \"class c\" size = \"7\" />\n"
+              "<var name = \"i\" type = \"int\"/>\n"
+              "</variables>\n"
+              "<function name=\"g\" returnValue=\"int\"/>\n"
+              "<class name = \"e\">\n"
+              "<field name = \"k\" typeF = \"int\"/>\n"
+              "</class>\n");
+    writeFile(dir / "job.txt",
+              "a i 2 + [] d . x .\n"
+              "field {x} of {field {d} of {{sum {i} and {2}}-th element of array {a}}}\n");
+    writeFile(dir / "broken.xml",
+              "<variables>\n"
+              "<var name = \"a\" type = \"int\"/>\n"
+              "<var name = \"a\" type = \"int\"/>\n"
+              "</variables>\n");
+
+    std::string pathExp = (dir / "job.txt").string();
+    bool passed = checkMemoryIsFlat("context", pathExp, (dir / "context.xml").string(), false, {});
+    //Измененная библиотека читается заново, а прежняя версия освобождается вместе с последним контекстом
+    passed = checkMemoryIsFlat("edited library", pathExp, (dir / "context.xml").string(), false, dir / "types.xml") && passed;
+    passed = checkMemoryIsFlat("broken context", pathExp, (dir / "broken.xml").string(), true, {}) && passed;
+
+    std::filesystem::remove_all(dir);
+
+    if(passed)
+        std::cout << "PASS" << std::endl;
+    return passed ? 0 : 1;
+}